@@ -0,0 +1,162 @@
+#!/usr/bin/env python3
+# Copyright (c) 2021 Saleem Abdulrasool.  All Rights Reserved.
+# SPDX-License-Identifier: BSD-3-Clause
+
+'''Generates a synthetic corpus of headers for benchmarking idt.
+
+The corpus consists of `headers` headers, each of which includes `fan_out` of
+the headers before it, and a translation unit per header which includes it.
+A `compile_commands.json` describing the translation units is written to the
+root of the corpus.  The corpus is deterministic for a given configuration.
+'''
+
+import argparse
+import json
+import os
+import random
+
+kExportMacro = 'CORPUS_ABI'
+kTarget = 'x86_64-unknown-windows-msvc'
+
+
+def add_arguments(parser):
+  parser.add_argument('--headers', type=int, default=200,
+                      help='the number of headers')
+  parser.add_argument('--declarations', type=int, default=50,
+                      help='the number of declarations per header')
+  parser.add_argument('--fan-out', type=int, default=4,
+                      help='the number of headers each header includes')
+  parser.add_argument('--templates', type=float, default=0.1,
+                      help='the fraction of declarations which are templates')
+  parser.add_argument('--classes', type=float, default=0.2,
+                      help='the fraction of declarations which are classes')
+  parser.add_argument('--annotated', type=float, default=0.5,
+                      help='the fraction of declarations which are annotated')
+  parser.add_argument('--seed', type=int, default=0,
+                      help='the seed for the corpus layout')
+
+
+def configuration(args):
+  return {
+    'headers': args.headers,
+    'declarations': args.declarations,
+    'fan_out': args.fan_out,
+    'templates': args.templates,
+    'classes': args.classes,
+    'annotated': args.annotated,
+    'seed': args.seed,
+  }
+
+
+def write_if_changed(path, contents):
+  if os.path.exists(path):
+    with open(path, 'r') as file:
+      if file.read() == contents:
+        return
+  with open(path, 'w') as file:
+    file.write(contents)
+
+
+def header(index, args, rng):
+  lines = ['#pragma once', '', '#include "corpus.hh"']
+  for dependency in sorted(rng.sample(range(index), min(index, args.fan_out))):
+    lines.append('#include "header_{}.hh"'.format(dependency))
+  lines.append('')
+  lines.append('namespace corpus_{} {{'.format(index))
+
+  for declaration in range(args.declarations):
+    abi = kExportMacro + ' ' if rng.random() < args.annotated else ''
+    name = 'declaration_{}'.format(declaration)
+    choice = rng.random()
+    if choice < args.templates:
+      if rng.random() < 0.5:
+        lines.append('template <typename T> T {}(T value) {{ return value; }}'
+                     .format(name))
+      else:
+        lines += [
+          'template <typename T> struct {} {{'.format(name),
+          '  T value;',
+          '  T get() const { return value; }',
+          '};',
+        ]
+    elif choice < args.templates + args.classes:
+      lines += [
+        'class {}{} {{'.format(abi, name),
+        'public:',
+        '  {}();'.format(name),
+        '  virtual ~{}();'.format(name),
+        '  int method(int) const;',
+        '  static int count;',
+        'private:',
+        '  void helper();',
+        '};',
+      ]
+    elif rng.random() < 0.8:
+      lines.append('{}int {}(int, const char *);'.format(abi, name))
+    else:
+      lines.append('{}extern int {};'.format(abi, name))
+
+  lines.append('}')
+  lines.append('')
+  return '\n'.join(lines)
+
+
+def source(index, args):
+  return '\n'.join([
+    '#include "header_{}.hh"'.format(index),
+    '',
+    'int use_{}() {{'.format(index),
+    '  return 0;',
+    '}',
+    '',
+  ])
+
+
+def generate(args, root):
+  '''Writes the corpus to `root`, returning the paths of the sources.'''
+  rng = random.Random(args.seed)
+
+  include = os.path.join(root, 'include')
+  sources = os.path.join(root, 'src')
+  os.makedirs(include, exist_ok=True)
+  os.makedirs(sources, exist_ok=True)
+
+  write_if_changed(os.path.join(include, 'corpus.hh'), '\n'.join([
+    '#pragma once',
+    '',
+    '#define {} __declspec(dllexport)'.format(kExportMacro),
+    '',
+  ]))
+
+  paths = []
+  commands = []
+  for index in range(args.headers):
+    write_if_changed(os.path.join(include, 'header_{}.hh'.format(index)),
+                     header(index, args, rng))
+    path = os.path.join(sources, 'source_{}.cc'.format(index))
+    write_if_changed(path, source(index, args))
+    paths.append(path)
+    commands.append({
+      'directory': root,
+      'file': path,
+      'arguments': [
+        'clang++', '--target=' + kTarget, '-std=c++17', '-fsyntax-only',
+        '-I', include, path,
+      ],
+    })
+
+  write_if_changed(os.path.join(root, 'compile_commands.json'),
+                   json.dumps(commands, indent=2) + '\n')
+  return paths
+
+
+def main():
+  parser = argparse.ArgumentParser(description=__doc__)
+  add_arguments(parser)
+  parser.add_argument('output', help='the directory to write the corpus to')
+  args = parser.parse_args()
+  generate(args, os.path.abspath(args.output))
+
+
+if __name__ == '__main__':
+  main()
@@ -0,0 +1,145 @@
+// Copyright (c) 2021 Saleem Abdulrasool.  All Rights Reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+
+// Times the traversal of idt's visitor, and each of the filters applied by
+// `idt::visitor::VisitFunctionDecl` in isolation, over ASTs which are parsed
+// once up front.  The results are in nanoseconds per declaration.
+
+#include "scanner.hh"
+
+#include "clang/Frontend/ASTUnit.h"
+#include "clang/Tooling/CommonOptionsParser.h"
+#include "clang/Tooling/Tooling.h"
+
+#include "llvm/Support/Format.h"
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+namespace {
+llvm::cl::opt<unsigned>
+iterations("iterations", llvm::cl::init(100),
+           llvm::cl::desc("The number of times to repeat each measurement"),
+           llvm::cl::value_desc("count"),
+           llvm::cl::cat(idt::category));
+
+// Keeps the results of the filters observable so that they are evaluated.
+volatile unsigned sink;
+
+class collector : public clang::RecursiveASTVisitor<collector> {
+public:
+  std::vector<const clang::FunctionDecl *> functions;
+
+  bool VisitFunctionDecl(clang::FunctionDecl *FD) {
+    functions.push_back(FD);
+    return true;
+  }
+};
+
+// The average time of `body`, in nanoseconds per `count` items.
+template <typename Body_>
+double measure(size_t count, Body_ &&body) {
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned iteration = 0; iteration < iterations; ++iteration)
+    body();
+  std::chrono::duration<double, std::nano> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return count ? elapsed.count() / (static_cast<double>(iterations) * count)
+               : 0.0;
+}
+
+void benchmark(clang::ASTUnit &unit, llvm::raw_ostream &OS) {
+  clang::ASTContext &context = unit.getASTContext();
+  clang::SourceManager &source_manager = context.getSourceManager();
+  clang::TranslationUnitDecl *TU = context.getTranslationUnitDecl();
+
+  // The remarks are still built, but are not rendered.
+  context.getDiagnostics().setSuppressAllDiagnostics(true);
+
+  collector functions;
+  functions.TraverseDecl(TU);
+
+  // The traversal of a scan without, and with, a report of the export
+  // surface, which collects the declarations into the inventory.
+  unsigned declarations = 0;
+  auto traverse = [&](bool collect) {
+    return measure(1, [&] {
+      idt::inventory inventory{collect};
+      idt::visitor visitor{context, inventory, /*client=*/false, /*unit=*/0};
+      visitor.TraverseDecl(TU);
+      declarations = visitor.declarations();
+    });
+  };
+  double traversal = traverse(/*collect=*/false);
+  double collection = traverse(/*collect=*/true);
+
+  OS << unit.getMainFileName() << ": " << declarations << " declarations, "
+     << functions.functions.size() << " functions\n"
+     << llvm::format("  %-16s %10.1f ns/declaration\n", "traversal",
+                     declarations ? traversal / declarations : 0.0)
+     << llvm::format("  %-16s %10.1f ns/declaration\n", "inventory",
+                     declarations ? collection / declarations : 0.0);
+
+  // The filters of `VisitFunctionDecl`, in the order in which it applies
+  // them, each timed over every function.
+  auto stage = [&](const char *name, auto &&filter) {
+    unsigned matches = 0;
+    double time = measure(functions.functions.size(), [&] {
+      for (const clang::FunctionDecl *FD : functions.functions)
+        matches += filter(FD);
+    });
+    sink = sink + matches;
+    OS << llvm::format("  %-16s %10.1f ns/function\n", name, time);
+  };
+
+  stage("system header", [&](const clang::FunctionDecl *FD) {
+    return source_manager.isInSystemHeader(
+        context.getFullLoc(FD->getBeginLoc()).getExpansionLoc());
+  });
+  stage("dependent", [](const clang::FunctionDecl *FD) {
+    return FD->isDependentContext();
+  });
+  stage("has body", [](const clang::FunctionDecl *FD) {
+    return FD->hasBody();
+  });
+  stage("friend", [](const clang::FunctionDecl *FD) {
+    return llvm::isa<clang::FriendDecl>(FD);
+  });
+  stage("deleted/defaulted", [](const clang::FunctionDecl *FD) {
+    return FD->isDeleted() || FD->isDefaulted();
+  });
+  stage("access", [](const clang::FunctionDecl *FD) {
+    return llvm::isa<clang::CXXMethodDecl>(FD) &&
+           FD->getAccess() == clang::AccessSpecifier::AS_private;
+  });
+  stage("attributes", [](const clang::FunctionDecl *FD) {
+    return FD->hasAttr<clang::DLLExportAttr>() ||
+           FD->hasAttr<clang::DLLImportAttr>();
+  });
+  stage("ignored", [](const clang::FunctionDecl *FD) {
+    return idt::contains(idt::get_ignored_functions(), FD->getNameAsString());
+  });
+}
+}
+
+int main(int argc, char *argv[]) {
+  using namespace clang::tooling;
+
+  auto options =
+      CommonOptionsParser::create(argc, const_cast<const char **>(argv),
+                                  idt::category, llvm::cl::OneOrMore);
+  if (!options) {
+    llvm::logAllUnhandledErrors(options.takeError(), llvm::errs());
+    return EXIT_FAILURE;
+  }
+
+  ClangTool tool{options->getCompilations(), options->getSourcePathList()};
+  std::vector<std::unique_ptr<clang::ASTUnit>> units;
+  int result = tool.buildASTs(units);
+
+  for (const auto &unit : units)
+    benchmark(*unit, llvm::outs());
+
+  return result;
+}
@@ -0,0 +1,203 @@
+#!/usr/bin/env python3
+# Copyright (c) 2021 Saleem Abdulrasool.  All Rights Reserved.
+# SPDX-License-Identifier: BSD-3-Clause
+
+'''Runs idt over a corpus and records its throughput.
+
+The `synthetic` benchmark generates (or refreshes) a corpus with
+generate-corpus.py and runs idt over every translation unit of it.  The
+`compilation-database` benchmark runs idt over a sample of the translation
+units of an existing compilation database with 1, 2, 4, ... workers, to
+measure how the scan scales.  The results are written as JSON for tracking
+over time.
+'''
+
+import argparse
+import importlib.util
+import json
+import os
+import random
+import subprocess
+import sys
+import tempfile
+import time
+
+
+def load_generator():
+  path = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                      'generate-corpus.py')
+  spec = importlib.util.spec_from_file_location('generate_corpus', path)
+  module = importlib.util.module_from_spec(spec)
+  spec.loader.exec_module(module)
+  return module
+
+
+def child_peak_memory():
+  '''The peak resident set size of the children, in bytes, if known.'''
+  try:
+    import resource
+  except ImportError:
+    return None
+  peak = resource.getrusage(resource.RUSAGE_CHILDREN).ru_maxrss
+  return peak if sys.platform == 'darwin' else peak * 1024
+
+
+def run(idt, database, sources, jobs, macro, arguments=()):
+  '''Runs idt, returning the elapsed time and the statistics of the run.'''
+  with tempfile.TemporaryDirectory() as scratch:
+    statistics = os.path.join(scratch, 'statistics.json')
+    command = [
+      idt, '-p', database, '-export-macro', macro, '-j', str(jobs),
+      '-stats-file', statistics,
+    ] + list(arguments) + sources
+
+    start = time.perf_counter()
+    process = subprocess.run(command, stdout=subprocess.DEVNULL,
+                             stderr=subprocess.DEVNULL)
+    elapsed = time.perf_counter() - start
+    if process.returncode != 0:
+      sys.exit('error: idt exited with {}'.format(process.returncode))
+
+    with open(statistics, 'r') as file:
+      return elapsed, json.load(file)
+
+
+def throughput(elapsed, statistics):
+  declarations = statistics['declarations']
+  units = statistics['translation_units']
+  inventory = statistics['inventory']
+  return {
+    'wall_time': elapsed,
+    'translation_units': units,
+    'declarations': declarations,
+    'findings': statistics['findings'],
+    'translation_units_per_second': units / elapsed,
+    'declarations_per_second': declarations / elapsed,
+    'inventory_hit_rate':
+        inventory['hits'] / inventory['lookups'] if inventory['lookups'] else 0,
+    'peak_memory': statistics['peak_memory'] or child_peak_memory(),
+  }
+
+
+def report(results):
+  print('{} translation units, {} declarations in {:.3f}s'
+        .format(results['translation_units'], results['declarations'],
+                results['wall_time']))
+  print('  {:.1f} translation units/s, {:.0f} declarations/s'
+        .format(results['translation_units_per_second'],
+                results['declarations_per_second']))
+  print('  inventory hit rate: {:.1%}, peak memory: {:.1f} MiB'
+        .format(results['inventory_hit_rate'],
+                (results['peak_memory'] or 0) / (1024 * 1024)))
+
+
+def synthetic(args, generator):
+  corpus = os.path.abspath(args.corpus)
+  sources = generator.generate(args, corpus)
+  elapsed, statistics = run(args.idt, corpus, sources, args.jobs,
+                            generator.kExportMacro)
+
+  results = dict({
+    'benchmark': 'synthetic-corpus',
+    'configuration': dict(generator.configuration(args), jobs=args.jobs),
+    'phases': statistics['phases'],
+  }, **throughput(elapsed, statistics))
+  report(results)
+  return results
+
+
+def compilation_database(args, generator):
+  database = os.path.abspath(args.database)
+  with open(os.path.join(database, 'compile_commands.json'), 'r') as file:
+    commands = json.load(file)
+
+  files = sorted({
+    os.path.normpath(os.path.join(command['directory'], command['file']))
+    for command in commands
+  })
+  if args.sample and args.sample < len(files):
+    files = sorted(random.Random(args.seed).sample(files, args.sample))
+
+  workers = [1]
+  while workers[-1] * 2 <= args.max_jobs:
+    workers.append(workers[-1] * 2)
+  if workers[-1] != args.max_jobs:
+    workers.append(args.max_jobs)
+
+  runs = []
+  for jobs in workers:
+    print('{} workers:'.format(jobs))
+    elapsed, statistics = run(args.idt, database, files, jobs,
+                              args.export_macro, args.idt_argument)
+    results = dict({'jobs': jobs}, **throughput(elapsed, statistics))
+    report(results)
+
+    speedup = runs[0]['wall_time'] / elapsed if runs else 1.0
+    results['speedup'] = speedup
+    results['efficiency'] = speedup / jobs
+    print('  speedup: {:.2f}x, efficiency: {:.1%}'
+          .format(speedup, speedup / jobs))
+    runs.append(results)
+
+  return {
+    'benchmark': 'compilation-database',
+    'configuration': {
+      'database': database,
+      'sources': len(files),
+      'sample': args.sample,
+      'seed': args.seed,
+      'export_macro': args.export_macro,
+      'arguments': args.idt_argument,
+    },
+    'runs': runs,
+  }
+
+
+def main():
+  generator = load_generator()
+
+  parser = argparse.ArgumentParser(description=__doc__)
+  parser.add_argument('--idt', required=True, help='the idt executable')
+  parser.add_argument('--results', required=True,
+                      help='the file to write the results to')
+  benchmarks = parser.add_subparsers(dest='benchmark', required=True)
+
+  parser_synthetic = benchmarks.add_parser('synthetic',
+                                           help='scan a synthetic corpus')
+  generator.add_arguments(parser_synthetic)
+  parser_synthetic.add_argument('--corpus', required=True,
+                                help='the directory to generate the corpus in')
+  parser_synthetic.add_argument('--jobs', type=int, default=1,
+                                help='the number of workers for idt')
+  parser_synthetic.set_defaults(benchmark=synthetic)
+
+  parser_database = benchmarks.add_parser(
+      'compilation-database', help='scan a sample of a compilation database')
+  parser_database.add_argument('--database', required=True,
+                               help='the directory of compile_commands.json')
+  parser_database.add_argument('--export-macro', required=True,
+                               help='the export macro of the tree')
+  parser_database.add_argument('--sample', type=int, default=0,
+                               help='the number of translation units to scan '
+                                    '(all if 0)')
+  parser_database.add_argument('--seed', type=int, default=0,
+                               help='the seed for the sample')
+  parser_database.add_argument('--max-jobs', type=int,
+                               default=os.cpu_count() or 1,
+                               help='the largest number of workers to scale '
+                                    'to')
+  parser_database.add_argument('--idt-argument', action='append', default=[],
+                               help='an additional argument for idt')
+  parser_database.set_defaults(benchmark=compilation_database)
+
+  args = parser.parse_args()
+  results = args.benchmark(args, generator)
+
+  with open(args.results, 'w') as file:
+    json.dump(results, file, indent=2)
+    file.write('\n')
+  print('results written to {}'.format(args.results))
+
+
+if __name__ == '__main__':
+  main()
@@ -0,0 +1,137 @@
+// Copyright (c) 2021 Saleem Abdulrasool.  All Rights Reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <cstdlib>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace {
+llvm::cl::opt<std::string>
+baseline(llvm::cl::Positional, llvm::cl::Required,
+         llvm::cl::desc("<baseline snapshot>"));
+
+llvm::cl::opt<std::string>
+revision(llvm::cl::Positional, llvm::cl::Required,
+         llvm::cl::desc("<revised snapshot>"));
+
+constexpr llvm::StringLiteral kHeader = "# idt snapshot 1";
+
+// A declaration of the exported surface, as written by `idt -snapshot`.
+struct declaration {
+  llvm::StringRef usr;
+  llvm::StringRef kind;
+  llvm::StringRef name;
+  llvm::StringRef signature;
+  llvm::StringRef attributes;
+
+  bool operator==(const declaration &rhs) const {
+    return kind == rhs.kind && name == rhs.name &&
+           signature == rhs.signature && attributes == rhs.attributes;
+  }
+  bool operator!=(const declaration &rhs) const { return !(*this == rhs); }
+};
+
+// A snapshot, held in memory and referenced by its declarations.
+struct snapshot {
+  std::unique_ptr<llvm::MemoryBuffer> buffer;
+  std::vector<declaration> declarations;
+};
+
+std::optional<snapshot> read_snapshot(llvm::StringRef path) {
+  auto buffer = llvm::MemoryBuffer::getFile(path, /*IsText=*/true);
+  if (!buffer) {
+    llvm::errs() << "error: unable to read '" << path
+                 << "': " << buffer.getError().message() << "\n";
+    return std::nullopt;
+  }
+
+  snapshot result{std::move(*buffer), {}};
+  llvm::StringRef contents = result.buffer->getBuffer();
+  if (!contents.starts_with(kHeader)) {
+    llvm::errs() << "error: '" << path << "' is not an idt snapshot\n";
+    return std::nullopt;
+  }
+
+  llvm::SmallVector<llvm::StringRef, 0> lines;
+  contents.split(lines, '\n', /*MaxSplit=*/-1, /*KeepEmpty=*/false);
+  result.declarations.reserve(lines.size());
+  for (unsigned index = 0; index < lines.size(); ++index) {
+    llvm::StringRef line = lines[index].rtrim('\r');
+    if (line.empty() || line.starts_with("#"))
+      continue;
+
+    llvm::SmallVector<llvm::StringRef, 5> fields;
+    line.split(fields, '\t');
+    if (fields.size() != 5) {
+      llvm::errs() << path << ":" << index + 1
+                   << ": error: malformed snapshot entry\n";
+      return std::nullopt;
+    }
+
+    declaration decl{fields[0], fields[1], fields[2], fields[3], fields[4]};
+    if (!result.declarations.empty() &&
+        !(result.declarations.back().usr < decl.usr)) {
+      llvm::errs() << path << ":" << index + 1
+                   << ": error: snapshot is not sorted\n";
+      return std::nullopt;
+    }
+    result.declarations.push_back(decl);
+  }
+  return result;
+}
+
+void print(llvm::raw_ostream &OS, const declaration &decl) {
+  OS << decl.signature << " [" << decl.attributes << "]";
+}
+}
+
+int main(int argc, char *argv[]) {
+  llvm::cl::ParseCommandLineOptions(argc, argv,
+                                    "idt exported surface snapshot differ\n");
+
+  auto old_surface = read_snapshot(baseline);
+  auto new_surface = read_snapshot(revision);
+  if (!old_surface || !new_surface)
+    return 2;
+
+  // Both snapshots are sorted by USR; walk them in lockstep.
+  const auto &lhs = old_surface->declarations;
+  const auto &rhs = new_surface->declarations;
+  unsigned added = 0, removed = 0, changed = 0;
+  auto l = lhs.begin(), r = rhs.begin();
+  while (l != lhs.end() || r != rhs.end()) {
+    if (r == rhs.end() || (l != lhs.end() && l->usr < r->usr)) {
+      llvm::outs() << "- " << l->kind << " '" << l->name << "': ";
+      print(llvm::outs(), *l);
+      llvm::outs() << "\n";
+      ++removed, ++l;
+    } else if (l == lhs.end() || r->usr < l->usr) {
+      llvm::outs() << "+ " << r->kind << " '" << r->name << "': ";
+      print(llvm::outs(), *r);
+      llvm::outs() << "\n";
+      ++added, ++r;
+    } else {
+      if (*l != *r) {
+        llvm::outs() << "~ " << r->kind << " '" << r->name << "': ";
+        print(llvm::outs(), *l);
+        llvm::outs() << " -> ";
+        print(llvm::outs(), *r);
+        llvm::outs() << "\n";
+        ++changed;
+      }
+      ++l, ++r;
+    }
+  }
+
+  llvm::outs() << added << " added, " << removed << " removed, " << changed
+               << " changed\n";
+  return added || removed || changed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
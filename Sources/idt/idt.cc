@@ -1,30 +1,56 @@
 // Copyright (c) 2021 Saleem Abdulrasool.  All Rights Reserved.
 // SPDX-License-Identifier: BSD-3-Clause
 
-#include "clang/AST/RecursiveASTVisitor.h"
+#include "scanner.hh"
+
 #include "clang/Basic/Diagnostic.h"
 #include "clang/Frontend/CompilerInstance.h"
+#include "clang/Frontend/TextDiagnostic.h"
+#include "clang/Frontend/TextDiagnosticPrinter.h"
+#include "clang/Index/USRGeneration.h"
+#include "clang/Lex/Lexer.h"
 #include "clang/Rewrite/Frontend/FixItRewriter.h"
 #include "clang/Tooling/CommonOptionsParser.h"
 #include "clang/Tooling/Tooling.h"
 
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringSwitch.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Support/TimeProfiler.h"
+#include "llvm/Support/VirtualFileSystem.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdlib>
-#include <iostream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <queue>
 #include <set>
 #include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
 
 namespace idt {
-llvm::cl::OptionCategory category{"interface definition scanner options"};
+enum class output_format : unsigned { text, jsonl, sarif, summary };
 }
 
 namespace {
 
-llvm::cl::opt<std::string>
-export_macro("export-macro",
-             llvm::cl::desc("The macro to decorate interfaces with"),
-             llvm::cl::value_desc("define"), llvm::cl::Required,
-             llvm::cl::cat(idt::category));
-
 llvm::cl::opt<bool>
 apply_fixits("apply-fixits", llvm::cl::init(false),
              llvm::cl::desc("Apply suggested changes to decorate interfaces"),
@@ -35,122 +61,1163 @@ inplace("inplace", llvm::cl::init(false),
         llvm::cl::desc("Apply suggested changes in-place"),
         llvm::cl::cat(idt::category));
 
+llvm::cl::opt<bool>
+export_report("export-report", llvm::cl::init(false),
+              llvm::cl::desc("Report the export surface of each header and library"),
+              llvm::cl::cat(idt::category));
+
+llvm::cl::list<std::string>
+max_exports("max-exports",
+            llvm::cl::desc("Fail if a library exports more symbols than the budget"),
+            llvm::cl::value_desc("[library=]count[,[library=]count...]"),
+            llvm::cl::CommaSeparated,
+            llvm::cl::cat(idt::category));
+
 llvm::cl::list<std::string>
-ignored_functions("ignore",
-                  llvm::cl::desc("Ignore one or more functions"),
-                  llvm::cl::value_desc("function-name[,function-name...]"),
-                  llvm::cl::CommaSeparated,
-                  llvm::cl::cat(idt::category));
+binaries("binary",
+         llvm::cl::desc("Cross-check the declarations against the export table of a built library"),
+         llvm::cl::value_desc("path"),
+         llvm::cl::cat(idt::category));
+
+llvm::cl::opt<std::string>
+emit_module_definition("emit-module-definition",
+                       llvm::cl::desc("Write the interface as a module-definition (.def) file"),
+                       llvm::cl::value_desc("path"),
+                       llvm::cl::cat(idt::category));
+
+llvm::cl::opt<std::string>
+emit_version_script("emit-version-script",
+                    llvm::cl::desc("Write the interface as a GNU linker version script"),
+                    llvm::cl::value_desc("path"),
+                    llvm::cl::cat(idt::category));
+
+llvm::cl::opt<std::string>
+emit_library("emit-library",
+             llvm::cl::desc("The library whose interface to write (defaults to all)"),
+             llvm::cl::value_desc("name"),
+             llvm::cl::cat(idt::category));
+
+llvm::cl::opt<std::string>
+module_name("module-name",
+            llvm::cl::desc("The module name (LIBRARY) or version node for the emitted interface"),
+            llvm::cl::value_desc("name"),
+            llvm::cl::cat(idt::category));
 
-template <typename Key, typename Compare, typename Allocator>
-bool contains(const std::set<Key, Compare, Allocator>& set, const Key& key) {
-  return set.find(key) != set.end();
+llvm::cl::opt<std::string>
+snapshot("snapshot",
+         llvm::cl::desc("Write a sorted snapshot of the exported surface for idt-diff"),
+         llvm::cl::value_desc("path"),
+         llvm::cl::cat(idt::category));
+
+// LLVM registers `-stats` for its own statistics, which it prints at exit.
+llvm::cl::opt<bool>
+print_statistics("statistics", llvm::cl::init(false),
+                 llvm::cl::desc("Print the time spent and the work done for each phase and translation unit"),
+                 llvm::cl::cat(idt::category));
+
+llvm::cl::opt<std::string>
+stats_file("stats-file",
+           llvm::cl::desc("Write the statistics of the run as JSON"),
+           llvm::cl::value_desc("path"),
+           llvm::cl::cat(idt::category));
+
+llvm::cl::opt<unsigned>
+jobs("j", llvm::cl::init(1),
+     llvm::cl::desc("The number of translation units to process concurrently (0 uses all hardware threads)"),
+     llvm::cl::value_desc("count"),
+     llvm::cl::cat(idt::category));
+
+llvm::cl::opt<std::string>
+time_trace("time-trace",
+           llvm::cl::desc("Write a Chrome trace of the run with a lane per worker"),
+           llvm::cl::value_desc("path"),
+           llvm::cl::cat(idt::category));
+
+llvm::cl::opt<unsigned>
+time_trace_granularity("time-trace-granularity", llvm::cl::init(500),
+                       llvm::cl::desc("The minimum duration of a traced span"),
+                       llvm::cl::value_desc("microseconds"),
+                       llvm::cl::cat(idt::category));
+
+llvm::cl::opt<bool>
+show_progress("progress", llvm::cl::init(false),
+              llvm::cl::desc("Show the progress of the scan on stderr"),
+              llvm::cl::cat(idt::category));
+
+llvm::cl::opt<idt::output_format>
+format("format", llvm::cl::init(idt::output_format::text),
+       llvm::cl::desc("The format of the findings"),
+       llvm::cl::values(clEnumValN(idt::output_format::text, "text",
+                                   "Remarks on stderr"),
+                        clEnumValN(idt::output_format::jsonl, "jsonl",
+                                   "A JSON object per finding on stdout"),
+                        clEnumValN(idt::output_format::sarif, "sarif",
+                                   "A SARIF 2.1.0 log on stdout"),
+                        clEnumValN(idt::output_format::summary, "summary",
+                                   "The number of each finding on stdout")),
+       llvm::cl::cat(idt::category));
+
+llvm::cl::opt<bool>
+sort_findings("sort-findings", llvm::cl::init(false),
+              llvm::cl::desc("Sort the findings by file, offset and kind, remove duplicates across translation units, and write other diagnostics in the order of their translation units"),
+              llvm::cl::cat(idt::category));
+
+llvm::cl::opt<unsigned>
+sort_memory("sort-memory", llvm::cl::init(256),
+            llvm::cl::desc("The memory to sort findings in before spilling them to sorted runs on disk"),
+            llvm::cl::value_desc("MiB"),
+            llvm::cl::cat(idt::category));
+
+// Parses the `-max-exports` budgets, keyed by library name.  A budget without
+// a library name applies to every library.
+llvm::Expected<std::map<std::string, unsigned>> get_export_budgets() {
+  std::map<std::string, unsigned> budgets;
+  for (const auto &specification : max_exports) {
+    auto [name, count] = llvm::StringRef(specification).rsplit('=');
+    if (count.empty())
+      std::swap(name, count);
+
+    unsigned budget;
+    if (count.getAsInteger(10, budget))
+      return llvm::make_error<llvm::StringError>(
+          "invalid export budget '" + specification + "'",
+          llvm::inconvertibleErrorCode());
+    // A budget for a library which no header belongs to would never apply.
+    if (!name.empty() && !idt::is_library(name))
+      return llvm::make_error<llvm::StringError>(
+          "export budget for unknown library '" + name + "'",
+          llvm::inconvertibleErrorCode());
+    budgets[name.str()] = budget;
+  }
+  return budgets;
 }
+}
+
+namespace idt {
+// Reads the ordinals of the exports of an existing module-definition file.
+// A missing or unreadable file has no ordinals.
+std::map<std::string, unsigned> read_ordinals(llvm::StringRef path) {
+  std::map<std::string, unsigned> ordinals;
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer =
+      llvm::MemoryBuffer::getFile(path, /*IsText=*/true);
+  if (!buffer)
+    return ordinals;
+
+  llvm::SmallVector<llvm::StringRef, 64> lines;
+  (*buffer)->getBuffer().split(lines, '\n');
+
+  bool exports = false;
+  for (llvm::StringRef line : lines) {
+    llvm::SmallVector<llvm::StringRef, 4> fields;
+    llvm::SplitString(line.split(';').first, fields);
+    if (fields.empty())
+      continue;
+
+    // Any other statement ends the exports.
+    bool statement = llvm::StringSwitch<bool>(fields.front())
+        .Cases("NAME", "LIBRARY", "DESCRIPTION", "STACKSIZE", true)
+        .Cases("HEAPSIZE", "SECTIONS", "VERSION", "IMPORTS", true)
+        .Case("EXPORTS", true)
+        .Default(false);
+    if (statement) {
+      exports = fields.front() == "EXPORTS";
+      continue;
+    }
+    if (!exports)
+      continue;
+
+    // entryname[=internalname] [@ordinal [NONAME]] [DATA] [PRIVATE]
+    llvm::StringRef name = fields.front().split('=').first;
+    for (size_t index = 1; index < fields.size(); ++index) {
+      llvm::StringRef field = fields[index];
+      if (!field.consume_front("@"))
+        continue;
+      if (field.empty() && index + 1 < fields.size())
+        field = fields[++index];
+      unsigned ordinal;
+      if (!field.getAsInteger(10, ordinal))
+        ordinals[name.str()] = ordinal;
+    }
+  }
+  return ordinals;
+}
+
+// Writes a module-definition file exporting `symbols`.  The symbols keep the
+// ordinals in `ordinals`, and new symbols are numbered after the highest of
+// them, so that binaries which import by ordinal remain compatible.  Class
+// symbols (vtables and type information) are data.
+void write_module_definition(
+    llvm::raw_ostream &OS,
+    const std::vector<std::pair<std::string, idt::kind>> &symbols,
+    const std::map<std::string, unsigned> &ordinals) {
+  if (!module_name.empty())
+    OS << "LIBRARY " << module_name << "\n";
+  OS << "EXPORTS\n";
 
-const std::set<std::string> &get_ignored_functions() {
-  static auto kIgnoredFunctions = [&]() -> std::set<std::string> {
-      return { ignored_functions.begin(), ignored_functions.end() };
-    }();
+  unsigned next = 0;
+  for (const auto &ordinal : ordinals)
+    next = std::max(next, ordinal.second);
 
-  return kIgnoredFunctions;
+  for (const auto &symbol : symbols) {
+    auto ordinal = ordinals.find(symbol.first);
+    OS << "  " << symbol.first << " @"
+       << (ordinal == ordinals.end() ? ++next : ordinal->second);
+    if (symbol.second != kind::function)
+      OS << " DATA";
+    OS << "\n";
+  }
 }
 
+// Writes a GNU version script exporting `symbols` and hiding everything else.
+void write_version_script(
+    llvm::raw_ostream &OS,
+    const std::vector<std::pair<std::string, idt::kind>> &symbols) {
+  if (!module_name.empty())
+    OS << module_name << " ";
+  OS << "{\n";
+  if (!symbols.empty()) {
+    OS << "  global:\n";
+    for (const auto &symbol : symbols)
+      OS << "    " << symbol.first << ";\n";
+  }
+  OS << "  local:\n"
+     << "    *;\n"
+     << "};\n";
 }
 
-namespace idt {
-class visitor : public clang::RecursiveASTVisitor<visitor> {
-  clang::ASTContext &context_;
-  clang::SourceManager &source_manager_;
+// Writes the interface with `writer` to `path`, returning false on failure.
+template <typename Writer_>
+bool write_interface(llvm::StringRef path, const idt::inventory &inventory,
+                     Writer_ &&writer) {
+  std::error_code error;
+  llvm::raw_fd_ostream OS{path, error, llvm::sys::fs::OF_Text};
+  if (error) {
+    llvm::errs() << "error: unable to write '" << path
+                 << "': " << error.message() << "\n";
+    return false;
+  }
+  writer(OS, inventory.interface(emit_library));
+  return true;
+}
+
+// Writes the snapshot of the exported surface to `path`, returning false on
+// failure.
+bool write_snapshot(llvm::StringRef path, const idt::inventory &inventory) {
+  std::error_code error;
+  llvm::raw_fd_ostream OS{path, error, llvm::sys::fs::OF_Text};
+  if (error) {
+    llvm::errs() << "error: unable to write '" << path
+                 << "': " << error.message() << "\n";
+    return false;
+  }
+  inventory.write_snapshot(OS);
+  return true;
+}
+
+// The worker running on this thread, used to attribute progress.
+thread_local unsigned worker = 0;
+
+// Tracks the progress of the scan for display on a terminal.  The workers
+// only update atomic counters; a separate thread renders them periodically.
+// Any other output during the scan goes through `interrupt`, which serializes
+// it with the rendering, and clears the progress line so that the output does
+// not follow it.
+class progress {
+  static constexpr size_t kIdle = ~size_t(0);
+  static constexpr unsigned kShownWorkers = 4;
+
+  const std::vector<std::string> &sources_;
+  llvm::StringMap<size_t> indices_;
+  std::vector<std::atomic<size_t>> current_;
+  std::atomic<unsigned> completed_{0};
+  std::atomic<uint64_t> declarations_{0};
+  std::chrono::steady_clock::time_point start_;
+
+  std::mutex mutex_;
+  std::condition_variable stop_;
+  bool stopped_ = false;
+  std::thread renderer_;
+
+  // Serializes the output on stderr.  `shown_` is set while the progress line
+  // is the last output on the terminal.
+  std::mutex output_;
+  bool shown_ = false;
+
+public:
+  progress(const std::vector<std::string> &sources, unsigned workers)
+      : sources_(sources), current_(workers) {
+    for (size_t index = 0; index < sources.size(); ++index)
+      indices_.try_emplace(get_normalized_path(sources[index]), index);
+    for (auto &current : current_)
+      current.store(kIdle, std::memory_order_relaxed);
+  }
+
+  // Notes that this worker has started on `file`.
+  void begin(llvm::StringRef file) {
+    auto index = indices_.find(file);
+    current_[worker].store(index == indices_.end() ? kIdle : index->second,
+                           std::memory_order_relaxed);
+  }
+
+  void traversed(unsigned declarations) {
+    declarations_.fetch_add(declarations, std::memory_order_relaxed);
+  }
+
+  // Notes that this worker has finished its file.
+  void end() {
+    current_[worker].store(kIdle, std::memory_order_relaxed);
+    completed_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Renders the progress every `interval` until stopped.
+  void start(std::chrono::milliseconds interval) {
+    start_ = std::chrono::steady_clock::now();
+    renderer_ = std::thread([this, interval] {
+      std::unique_lock<std::mutex> lock{mutex_};
+      while (!stop_.wait_for(lock, interval, [this] { return stopped_; }))
+        render(/*final=*/false);
+    });
+  }
+
+  void stop() {
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      stopped_ = true;
+    }
+    stop_.notify_one();
+    renderer_.join();
+    render(/*final=*/true);
+  }
+
+  // Runs `output`, which writes to stderr or to the same terminal, without
+  // racing with the renderer.  The next update redraws the progress line.
+  template <typename Output_>
+  void interrupt(Output_ &&output) {
+    std::lock_guard<std::mutex> lock{output_};
+    if (shown_) {
+      llvm::errs() << "\r\x1b[K";
+      shown_ = false;
+    }
+    output();
+  }
+
+private:
+  void render(bool final) {
+    static const bool kDisplayed = llvm::sys::Process::StandardErrIsDisplayed();
+
+    unsigned completed = completed_.load(std::memory_order_relaxed);
+    uint64_t declarations = declarations_.load(std::memory_order_relaxed);
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start_;
 
-  clang::DiagnosticBuilder
-  unexported_public_interface(clang::SourceLocation location) {
-    clang::DiagnosticsEngine &diagnostics_engine = context_.getDiagnostics();
+    std::string line;
+    llvm::raw_string_ostream OS{line};
+    OS << "[" << completed << "/" << sources_.size() << "] "
+       << llvm::format("%.0f", elapsed.count() > 0
+                                   ? declarations / elapsed.count()
+                                   : 0.0)
+       << " declarations/s, ETA ";
+    if (completed && completed < sources_.size()) {
+      unsigned remaining = static_cast<unsigned>(
+          elapsed.count() / completed * (sources_.size() - completed));
+      OS << llvm::format("%02u:%02u", remaining / 60, remaining % 60);
+    } else {
+      OS << (completed ? "00:00" : "--:--");
+    }
 
-    static unsigned kID =
-        diagnostics_engine.getCustomDiagID(clang::DiagnosticsEngine::Remark,
-                                           "unexported public interface %0");
+    unsigned shown = 0, active = 0;
+    for (unsigned index = 0; index < current_.size(); ++index) {
+      size_t current = current_[index].load(std::memory_order_relaxed);
+      if (current == kIdle)
+        continue;
+      if (++active > kShownWorkers)
+        continue;
+      OS << (shown++ ? ", " : " | ") << "worker " << index << ": "
+         << llvm::sys::path::filename(sources_[current]);
+    }
+    if (active > shown)
+      OS << ", +" << active - shown << " more";
+    OS.flush();
 
-    return diagnostics_engine.Report(location, kID);
+    // Overwrite the previous line on a terminal; elsewhere, e.g. in a log,
+    // emit a line per update.
+    std::lock_guard<std::mutex> lock{output_};
+    if (kDisplayed)
+      llvm::errs() << "\r" << line << "\x1b[K";
+    else
+      llvm::errs() << line << "\n";
+    if (final && kDisplayed)
+      llvm::errs() << "\n";
+    shown_ = kDisplayed && !final;
   }
+};
+
+// A finding, as written in the machine-readable formats.
+struct record {
+  // The replacement of `length` bytes at `offset` in `file` with `text`.
+  struct replacement {
+    std::string file;
+    unsigned offset;
+    unsigned length;
+    std::string text;
+  };
+
+  idt::finding finding;
+  std::string message;
+  std::string file;
+  unsigned line = 0;
+  unsigned column = 0;
+  std::string name;
+  std::string usr;
+  std::vector<replacement> fixits;
+  std::string unit;
+};
+
+// The URI reference of `path` which SARIF locates artifacts by.
+std::string get_uri(llvm::StringRef path) {
+  std::string slashed = llvm::sys::path::convert_to_slash(path);
+
+  std::string uri;
+  llvm::raw_string_ostream OS{uri};
+  if (llvm::sys::path::is_absolute(path))
+    OS << (llvm::StringRef(slashed).starts_with("/") ? "file://" : "file:///");
+  for (char c : slashed)
+    if (llvm::isAlnum(c) || llvm::StringRef("-._~/:").contains(c))
+      OS << c;
+    else
+      OS << '%'
+         << llvm::format_hex_no_prefix(static_cast<unsigned char>(c), 2,
+                                       /*Upper=*/true);
+  OS.flush();
+  return uri;
+}
+
+// The base of the URIs of relative paths, which are relative to the directory
+// idt was run from.
+constexpr const char kSourceRoot[] = "%SRCROOT%";
+
+// Writes the artifact location of `path`, resolving a relative path against
+// the source root.
+void write_artifact_location(llvm::json::OStream &J, llvm::StringRef path) {
+  J.attributeObject("artifactLocation", [&] {
+    J.attribute("uri", get_uri(path));
+    if (!llvm::sys::path::is_absolute(path))
+      J.attribute("uriBaseId", kSourceRoot);
+  });
+}
+
+void write_jsonl(llvm::json::OStream &J, const record &record) {
+  J.object([&] {
+    J.attribute("kind", kFindings[static_cast<unsigned>(record.finding)].name);
+    J.attribute("file", record.file);
+    J.attribute("line", record.line);
+    J.attribute("column", record.column);
+    J.attribute("name", record.name);
+    J.attribute("usr", record.usr);
+    J.attributeArray("fixits", [&] {
+      for (const auto &fixit : record.fixits)
+        J.object([&] {
+          J.attribute("file", fixit.file);
+          J.attribute("offset", fixit.offset);
+          J.attribute("length", fixit.length);
+          J.attribute("text", fixit.text);
+        });
+    });
+    J.attribute("unit", record.unit);
+  });
+}
+
+// Writes `record` as a SARIF result, whose rule is the index of the finding
+// in the rules of the tool.  The fix-its are a single fix, which changes each
+// file with a replacement per fix-it, as they must be applied together.
+void write_sarif(llvm::json::OStream &J, const record &record) {
+  unsigned rule = static_cast<unsigned>(record.finding);
+  J.object([&] {
+    J.attribute("ruleId", kFindings[rule].name);
+    J.attribute("ruleIndex", rule);
+    J.attribute("level", "note");
+    J.attributeObject("message", [&] {
+      J.attribute("text", record.message);
+    });
+    J.attributeArray("locations", [&] {
+      J.object([&] {
+        J.attributeObject("physicalLocation", [&] {
+          write_artifact_location(J, record.file);
+          if (record.line)
+            J.attributeObject("region", [&] {
+              J.attribute("startLine", record.line);
+              J.attribute("startColumn", record.column);
+            });
+        });
+        if (!record.name.empty())
+          J.attributeArray("logicalLocations", [&] {
+            J.object([&] {
+              J.attribute("fullyQualifiedName", record.name);
+            });
+          });
+      });
+    });
+    if (!record.fixits.empty()) {
+      // The files which the fix-its change, in the order of their first
+      // fix-it.
+      std::vector<llvm::StringRef> files;
+      for (const auto &fixit : record.fixits)
+        if (!llvm::is_contained(files, fixit.file))
+          files.push_back(fixit.file);
+
+      J.attributeArray("fixes", [&] {
+        J.object([&] {
+          J.attributeArray("artifactChanges", [&] {
+            for (llvm::StringRef file : files)
+              J.object([&] {
+                write_artifact_location(J, file);
+                J.attributeArray("replacements", [&] {
+                  for (const auto &fixit : record.fixits) {
+                    if (fixit.file != file)
+                      continue;
+                    J.object([&] {
+                      J.attributeObject("deletedRegion", [&] {
+                        J.attribute("byteOffset", fixit.offset);
+                        J.attribute("byteLength", fixit.length);
+                      });
+                      if (!fixit.text.empty())
+                        J.attributeObject("insertedContent", [&] {
+                          J.attribute("text", fixit.text);
+                        });
+                    });
+                  }
+                });
+              });
+          });
+        });
+      });
+    }
+    J.attributeObject("properties", [&] {
+      J.attribute("usr", record.usr);
+      J.attribute("translationUnit", record.unit);
+    });
+  });
+}
 
-  clang::DiagnosticBuilder
-  exported_private_interface(clang::SourceLocation location) {
-    clang::DiagnosticsEngine &diagnostics_engine = context_.getDiagnostics();
+// A finding formatted for output, with the key by which the findings are
+// sorted and their duplicates across translation units removed.  Of the
+// duplicates, the one from the translation unit whose path sorts first is
+// kept.  The declaration, its USR or else its qualified name, tells apart the
+// declarations of a single macro expansion, which share its location.
+struct finding_entry {
+  std::string file;
+  uint32_t offset;
+  idt::finding finding;
+  std::string declaration;
+  std::string unit;
+  std::string text;
 
-    static unsigned kID =
-        diagnostics_engine.getCustomDiagID(clang::DiagnosticsEngine::Remark,
-                                           "exported private interface %0");
+  bool operator<(const finding_entry &other) const {
+    return std::tie(file, offset, finding, declaration, unit) <
+           std::tie(other.file, other.offset, other.finding,
+                    other.declaration, other.unit);
+  }
 
-    return diagnostics_engine.Report(location, kID);
+  bool duplicates(const finding_entry &other) const {
+    return std::tie(file, offset, finding, declaration) ==
+           std::tie(other.file, other.offset, other.finding,
+                    other.declaration);
   }
 
-  template <typename Decl_>
-  inline clang::FullSourceLoc get_location(const Decl_ *TD) const {
-    return context_.getFullLoc(TD->getBeginLoc()).getExpansionLoc();
+  size_t size() const {
+    return sizeof(finding_entry) + file.size() + declaration.size() +
+           unit.size() + text.size();
   }
+};
+
+void write_entry(llvm::raw_ostream &OS, const finding_entry &entry) {
+  auto write = [&OS](uint32_t value) {
+    llvm::support::endian::write(OS, value, llvm::support::little);
+  };
+  auto write_string = [&](llvm::StringRef value) {
+    write(static_cast<uint32_t>(value.size()));
+    OS << value;
+  };
+
+  write_string(entry.file);
+  write(entry.offset);
+  write(static_cast<uint32_t>(entry.finding));
+  write_string(entry.declaration);
+  write_string(entry.unit);
+  write_string(entry.text);
+}
+
+// Reads back a sorted run of entries which the writer spilled to disk.
+class sorted_run {
+  std::unique_ptr<llvm::MemoryBuffer> buffer_;
+  llvm::StringRef data_;
 
 public:
-  explicit visitor(clang::ASTContext &context)
-      : context_(context), source_manager_(context.getSourceManager()) {}
+  explicit sorted_run(std::unique_ptr<llvm::MemoryBuffer> buffer)
+      : buffer_(std::move(buffer)), data_(buffer_->getBuffer()) {}
 
-  bool VisitFunctionDecl(clang::FunctionDecl *FD) {
-    clang::FullSourceLoc location = get_location(FD);
+  bool next(finding_entry &entry) {
+    uint32_t finding;
+    if (!read(entry.file) || !read(entry.offset) || !read(finding) ||
+        !read(entry.declaration) || !read(entry.unit) || !read(entry.text))
+      return false;
+    entry.finding = static_cast<idt::finding>(finding);
+    return true;
+  }
 
-    // Ignore declarations from the system.
-    if (source_manager_.isInSystemHeader(location))
-      return true;
+private:
+  bool read(uint32_t &value) {
+    if (data_.size() < sizeof(value))
+      return false;
+    value = llvm::support::endian::read32le(data_.data());
+    data_ = data_.drop_front(sizeof(value));
+    return true;
+  }
 
-    // We are only interested in non-dependent types.
-    if (FD->isDependentContext())
-      return true;
+  bool read(std::string &value) {
+    uint32_t size;
+    if (!read(size) || data_.size() < size)
+      return false;
+    value = data_.take_front(size).str();
+    data_ = data_.drop_front(size);
+    return true;
+  }
+};
 
-    // If the function has a body, it can be materialized by the user.
-    if (FD->hasBody())
-      return true;
+// The output of the translation unit `unit`: its findings, either formatted in
+// a machine-readable format, counted, or as entries to sort, and its other
+// diagnostics as text.
+struct batch {
+  batch *next = nullptr;
+  std::string unit;
+  std::string findings;
+  std::array<uint64_t, std::size(kFindings)> counts{};
+  std::vector<finding_entry> entries;
+  std::string diagnostics;
+};
 
-    // Ignore friend declarations.
-    if (llvm::isa<clang::FriendDecl>(FD))
-      return true;
+// Writes the output of the translation units from a single thread, a batch at
+// a time, so that the output of a translation unit is never interleaved with
+// another.  The workers hand their batches over through a lock-free stack, and
+// only take the mutex to wake the writer when it is idle.  The results of the
+// batches are written into a single SARIF log, whose prologue and rules are
+// written up front, and which `close` completes.
+//
+// Sorted findings are instead held until `close` writes them.  Once they
+// exceed `limit` bytes, they are sorted and spilled to a run on disk, and the
+// runs are merged at the end.  The other diagnostics are then held in memory
+// too, and written ahead of the findings in the order of their translation
+// units.
+class writer {
+  llvm::raw_ostream &findings_;
+  llvm::raw_ostream &diagnostics_;
+  idt::progress *progress_;
+  idt::output_format format_;
+  std::optional<llvm::json::OStream> log_;
 
-    // Ignore deleted and defaulted functions (e.g. operators).
-    if (FD->isDeleted() || FD->isDefaulted())
-      return true;
+  bool sort_;
+  size_t limit_;
+  size_t size_ = 0;
+  std::vector<finding_entry> entries_;
+  std::vector<std::string> runs_;
+  std::vector<std::pair<std::string, std::string>> unit_diagnostics_;
+  std::array<uint64_t, std::size(kFindings)> counts_{};
+
+  std::atomic<batch *> pending_{nullptr};
+  std::atomic<bool> idle_{false};
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  bool stopped_ = false;
+  std::thread thread_;
+
+public:
+  writer(llvm::raw_ostream &findings, llvm::raw_ostream &diagnostics,
+         idt::progress *progress, idt::output_format format, bool sort,
+         size_t limit)
+      : findings_(findings), diagnostics_(diagnostics), progress_(progress),
+        format_(format), sort_(sort), limit_(limit) {
+    if (format == idt::output_format::sarif) {
+      log_.emplace(findings_);
+      llvm::json::OStream &J = *log_;
+      J.objectBegin();
+      J.attribute("$schema", "https://json.schemastore.org/sarif-2.1.0.json");
+      J.attribute("version", "2.1.0");
+      J.attributeBegin("runs");
+      J.arrayBegin();
+      J.objectBegin();
+      J.attributeObject("tool", [&] {
+        J.attributeObject("driver", [&] {
+          J.attribute("name", "idt");
+          J.attributeArray("rules", [&] {
+            for (const auto &finding : kFindings)
+              J.object([&] {
+                J.attribute("id", finding.name);
+                J.attributeObject("defaultConfiguration", [&] {
+                  J.attribute("level", "note");
+                });
+              });
+          });
+        });
+      });
+      llvm::SmallString<256> directory;
+      if (!llvm::sys::fs::current_path(directory))
+        J.attributeObject("originalUriBaseIds", [&] {
+          J.attributeObject(kSourceRoot, [&] {
+            J.attribute("uri", get_uri(directory) + "/");
+          });
+        });
+      J.attributeBegin("results");
+      J.arrayBegin();
+    }
+
+    thread_ = std::thread([this] { run(); });
+  }
+
+  void submit(std::unique_ptr<batch> batch) {
+    idt::batch *head = batch.release();
+    head->next = pending_.load(std::memory_order_relaxed);
+    while (!pending_.compare_exchange_weak(head->next, head))
+      ;
+
+    // The writer publishes that it is idle before it checks for batches, so
+    // either it finds this batch, or this finds it idle and wakes it.
+    if (idle_.load()) {
+      { std::lock_guard<std::mutex> lock{mutex_}; }
+      wake_.notify_one();
+    }
+  }
+
+  // Writes the remaining batches and completes the output.
+  void close() {
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      stopped_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+
+    if (sort_) {
+      std::sort(unit_diagnostics_.begin(), unit_diagnostics_.end());
+      for (const auto &diagnostics : unit_diagnostics_)
+        diagnostics_ << diagnostics.second;
+      merge();
+    }
+
+    if (format_ == idt::output_format::summary)
+      for (unsigned index = 0; index < std::size(kFindings); ++index)
+        findings_ << kFindings[index].name << " " << counts_[index] << "\n";
+
+    if (log_) {
+      llvm::json::OStream &J = *log_;
+      J.arrayEnd();
+      J.attributeEnd();
+      J.objectEnd();
+      J.arrayEnd();
+      J.attributeEnd();
+      J.objectEnd();
+      findings_ << '\n';
+    }
+    findings_.flush();
+  }
+
+private:
+  void run() {
+    llvm::set_thread_name("idt writer");
+
+    for (;;) {
+      batch *head = pending_.exchange(nullptr);
+      if (!head) {
+        std::unique_lock<std::mutex> lock{mutex_};
+        idle_.store(true);
+        wake_.wait(lock, [this] { return stopped_ || pending_.load(); });
+        idle_.store(false);
+        if (!pending_.load())
+          return;
+        continue;
+      }
+
+      // The stack has the most recent batch first.
+      batch *ordered = nullptr;
+      while (head) {
+        batch *next = head->next;
+        head->next = ordered;
+        ordered = head;
+        head = next;
+      }
+
+      auto output = [&] {
+        while (ordered) {
+          std::unique_ptr<batch> current{ordered};
+          ordered = ordered->next;
+          write(*current);
+        }
+        diagnostics_.flush();
+        findings_.flush();
+      };
+      if (progress_)
+        progress_->interrupt(output);
+      else
+        output();
+    }
+  }
+
+  void write(batch &batch) {
+    for (unsigned index = 0; index < std::size(kFindings); ++index)
+      counts_[index] += batch.counts[index];
 
-    if (const auto *MD = llvm::dyn_cast<clang::CXXMethodDecl>(FD)) {
-      // Ignore private members (except for a negative check).
-      if (MD->getAccess() == clang::AccessSpecifier::AS_private) {
-        // TODO(compnerd) this should also handle `__visibility__`
-        if (MD->hasAttr<clang::DLLExportAttr>())
-          // TODO(compnerd) this should emit a fix-it to remove the attribute
-          exported_private_interface(location) << MD;
-        return true;
+    if (sort_) {
+      if (!batch.diagnostics.empty())
+        unit_diagnostics_.emplace_back(std::move(batch.unit),
+                                       std::move(batch.diagnostics));
+      for (auto &entry : batch.entries) {
+        size_ += entry.size();
+        entries_.push_back(std::move(entry));
       }
+      if (size_ > limit_)
+        spill();
+      return;
+    }
+
+    diagnostics_ << batch.diagnostics;
+    if (!log_)
+      findings_ << batch.findings;
+    else if (!batch.findings.empty())
+      // The comma separated results of the batch, as a single value.
+      log_->rawValue(batch.findings);
+  }
+
+  void emit(const finding_entry &entry) {
+    if (format_ == idt::output_format::summary)
+      ++counts_[static_cast<unsigned>(entry.finding)];
+    else if (log_)
+      log_->rawValue(entry.text);
+    else if (format_ == idt::output_format::text)
+      diagnostics_ << entry.text;
+    else
+      findings_ << entry.text;
+  }
+
+  // Sorts the entries in memory, and removes their duplicates.
+  void sort() {
+    std::sort(entries_.begin(), entries_.end());
+    auto duplicates = [](const finding_entry &lhs, const finding_entry &rhs) {
+      return lhs.duplicates(rhs);
+    };
+    entries_.erase(std::unique(entries_.begin(), entries_.end(), duplicates),
+                   entries_.end());
+  }
 
-      // Pure virtual methods cannot be exported.
-      if (MD->isPure())
-        return true;
+  void spill() {
+    sort();
+
+    int fd;
+    llvm::SmallString<128> path;
+    if (std::error_code error =
+            llvm::sys::fs::createTemporaryFile("idt-findings", "run", fd,
+                                               path)) {
+      llvm::errs() << "warning: unable to spill the findings: "
+                   << error.message() << "\n";
+      limit_ = std::numeric_limits<size_t>::max();
+      return;
     }
 
-    // If the function has a dll-interface, it is properly annotated.
-    // TODO(compnerd) this should also handle `__visibility__`
-    if (FD->hasAttr<clang::DLLExportAttr>() ||
-        FD->hasAttr<clang::DLLImportAttr>())
-      return true;
+    llvm::raw_fd_ostream OS{fd, /*shouldClose=*/true};
+    for (const auto &entry : entries_)
+      write_entry(OS, entry);
+    OS.close();
+    if (OS.has_error()) {
+      llvm::errs() << "warning: unable to spill the findings: "
+                   << OS.error().message() << "\n";
+      OS.clear_error();
+      llvm::sys::fs::remove(path);
+      limit_ = std::numeric_limits<size_t>::max();
+      return;
+    }
+
+    runs_.push_back(std::string(path));
+    entries_.clear();
+    size_ = 0;
+  }
+
+  // Writes the entries of the runs and those in memory in order, without
+  // their duplicates.
+  void merge() {
+    sort();
+    if (runs_.empty()) {
+      for (const auto &entry : entries_)
+        emit(entry);
+      return;
+    }
+
+    std::vector<sorted_run> runs;
+    for (const auto &path : runs_) {
+      auto buffer =
+          llvm::MemoryBuffer::getFile(path, /*IsText=*/false,
+                                      /*RequiresNullTerminator=*/false);
+      if (!buffer) {
+        llvm::errs() << "error: unable to read the findings from '" << path
+                     << "': " << buffer.getError().message() << "\n";
+        continue;
+      }
+      runs.emplace_back(std::move(*buffer));
+    }
+
+    // The head of each run, followed by the next entry in memory.
+    std::vector<finding_entry> heads(runs.size() + 1);
+    auto compare = [&heads](size_t lhs, size_t rhs) {
+      return heads[rhs] < heads[lhs];
+    };
+    std::priority_queue<size_t, std::vector<size_t>, decltype(compare)>
+        queue{compare};
 
-    // Ignore known forward declarations (builtins)
-    // TODO(compnerd) replace with std::set::contains in C++20
-    if (contains(get_ignored_functions(), FD->getNameAsString()))
+    size_t next = 0;
+    auto advance = [&](size_t source) {
+      if (source < runs.size())
+        return runs[source].next(heads[source]);
+      if (next == entries_.size())
+        return false;
+      heads[source] = std::move(entries_[next++]);
       return true;
+    };
 
-    clang::SourceLocation insertion_point =
-        FD->getTemplatedKind() == clang::FunctionDecl::TK_NonTemplate
-            ? FD->getBeginLoc()
-            : FD->getInnerLocStart();
-    unexported_public_interface(location)
-        << FD
-        << clang::FixItHint::CreateInsertion(insertion_point,
-                                             export_macro + " ");
-    return true;
+    for (size_t source = 0; source < heads.size(); ++source)
+      if (advance(source))
+        queue.push(source);
+
+    std::optional<finding_entry> last;
+    while (!queue.empty()) {
+      size_t source = queue.top();
+      queue.pop();
+
+      if (!last || !last->duplicates(heads[source])) {
+        emit(heads[source]);
+        last = std::move(heads[source]);
+      }
+
+      if (advance(source))
+        queue.push(source);
+    }
+
+    runs.clear();
+    for (const auto &path : runs_)
+      llvm::sys::fs::remove(path);
+  }
+};
+
+// Buffers the output of a translation unit, which it hands to `writer` once
+// the translation unit is done with the diagnostics.  The findings are
+// recorded in the machine-readable `format`, if any, or as entries to sort;
+// any other diagnostic is printed as text.
+class buffered_consumer : public clang::DiagnosticConsumer {
+  idt::writer &writer_;
+  idt::output_format format_;
+  bool sort_;
+  std::string unit_;
+  std::unique_ptr<idt::batch> batch_;
+  llvm::raw_string_ostream OS_;
+  llvm::IntrusiveRefCntPtr<clang::DiagnosticOptions> options_;
+  clang::TextDiagnosticPrinter printer_;
+  const clang::LangOptions *lang_options_ = nullptr;
+
+public:
+  buffered_consumer(idt::writer &writer, idt::output_format format, bool sort,
+                    std::string unit, clang::DiagnosticOptions &options)
+      : writer_(writer), format_(format), sort_(sort), unit_(std::move(unit)),
+        batch_(std::make_unique<idt::batch>()), OS_(batch_->diagnostics),
+        options_(&options), printer_(OS_, &options) {
+    batch_->unit = unit_;
+  }
+
+  ~buffered_consumer() override {
+    OS_.flush();
+    writer_.submit(std::move(batch_));
+  }
+
+  void BeginSourceFile(const clang::LangOptions &lang_options,
+                       const clang::Preprocessor *preprocessor) override {
+    lang_options_ = &lang_options;
+    printer_.BeginSourceFile(lang_options, preprocessor);
+  }
+
+  void EndSourceFile() override {
+    printer_.EndSourceFile();
+  }
+
+  void finish() override {
+    printer_.finish();
+  }
+
+  void HandleDiagnostic(clang::DiagnosticsEngine::Level level,
+                        const clang::Diagnostic &diagnostic) override {
+    clang::DiagnosticConsumer::HandleDiagnostic(level, diagnostic);
+
+    std::optional<idt::finding> finding;
+    if ((sort_ || format_ != idt::output_format::text) && lang_options_ &&
+        diagnostic.hasSourceManager())
+      finding = get_finding(*diagnostic.getDiags()->getDiagnosticIDs(),
+                            diagnostic.getID());
+    if (!finding)
+      return printer_.HandleDiagnostic(level, diagnostic);
+
+    const clang::SourceManager &source_manager =
+        diagnostic.getSourceManager();
+
+    llvm::SmallString<128> message;
+    diagnostic.FormatDiagnostic(message);
+
+    const clang::NamedDecl *ND = nullptr;
+    for (unsigned index = 0; index < diagnostic.getNumArgs(); ++index)
+      if (diagnostic.getArgKind(index) ==
+          clang::DiagnosticsEngine::ak_nameddecl)
+        ND = reinterpret_cast<const clang::NamedDecl *>(
+            diagnostic.getRawArg(index));
+
+    if (format_ != idt::output_format::text)
+      return add(*finding, diagnostic.getLocation(), ND,
+                 diagnostic.getFixItHints(), message, source_manager);
+
+    // Render the remark afresh, without the include stack of any previous
+    // remark, so that it is the same wherever it is sorted to.
+    idt::finding_entry entry =
+        get_entry(*finding, diagnostic.getLocation(), ND, source_manager);
+    llvm::raw_string_ostream OS{entry.text};
+    clang::TextDiagnostic{OS, *lang_options_, options_.get()}.emitDiagnostic(
+        clang::FullSourceLoc(diagnostic.getLocation(), source_manager), level,
+        message, diagnostic.getRanges(), diagnostic.getFixItHints());
+    OS.flush();
+    batch_->entries.push_back(std::move(entry));
+  }
+
+  // Adds the findings which the visitor of `context` recorded in place of
+  // reporting them.  A summary only counts them, and only SARIF has their
+  // message.
+  void add(const clang::ASTContext &context,
+           llvm::ArrayRef<idt::recorded_finding> findings) {
+    for (const auto &finding : findings) {
+      std::string message;
+      if (format_ == idt::output_format::sarif) {
+        llvm::raw_string_ostream OS{message};
+        auto [prefix, suffix] =
+            llvm::StringRef(kFindings[static_cast<unsigned>(finding.finding)]
+                                .message).split("%0");
+        OS << prefix << "'";
+        finding.declaration->getNameForDiagnostic(
+            OS, context.getPrintingPolicy(), /*Qualified=*/false);
+        OS << "'" << suffix;
+        OS.flush();
+      }
+
+      add(finding.finding, finding.location, finding.declaration,
+          finding.fixits, message, context.getSourceManager());
+    }
+  }
+
+private:
+  void add(idt::finding finding, clang::SourceLocation location,
+           const clang::NamedDecl *ND, llvm::ArrayRef<clang::FixItHint> fixits,
+           llvm::StringRef message,
+           const clang::SourceManager &source_manager) {
+    if (format_ == idt::output_format::summary && !sort_) {
+      ++batch_->counts[static_cast<unsigned>(finding)];
+      return;
+    }
+
+    if (!sort_) {
+      llvm::raw_string_ostream OS{batch_->findings};
+      if (format_ == idt::output_format::sarif && !batch_->findings.empty())
+        OS << ',';
+      format(OS, get_record(finding, location, ND, fixits, message,
+                            source_manager));
+      return;
+    }
+
+    idt::finding_entry entry =
+        get_entry(finding, location, ND, source_manager);
+    if (format_ != idt::output_format::summary) {
+      llvm::raw_string_ostream OS{entry.text};
+      format(OS, get_record(finding, location, ND, fixits, message,
+                            source_manager));
+    }
+    batch_->entries.push_back(std::move(entry));
+  }
+
+  // The entry to sort `finding` by, without its text.  The same finding has
+  // the same file, offset and declaration in every translation unit, however
+  // the file was spelled.
+  idt::finding_entry get_entry(idt::finding finding,
+                               clang::SourceLocation location,
+                               const clang::NamedDecl *ND,
+                               const clang::SourceManager &source_manager) {
+    std::pair<clang::FileID, unsigned> decomposed =
+        source_manager.getDecomposedExpansionLoc(location);
+    idt::finding_entry entry{"", decomposed.second, finding, "", unit_, ""};
+    if (ND) {
+      llvm::SmallString<128> usr;
+      if (!clang::index::generateUSRForDecl(ND, usr))
+        entry.declaration = usr.str().str();
+      else
+        entry.declaration = ND->getQualifiedNameAsString();
+    }
+    if (auto file = source_manager.getFileEntryRefForID(decomposed.first)) {
+      entry.file = file->getFileEntry().tryGetRealPathName().str();
+      if (entry.file.empty())
+        entry.file = get_normalized_path(source_manager.getFileManager(),
+                                         file->getName());
+    }
+    return entry;
+  }
+
+  idt::record get_record(idt::finding finding, clang::SourceLocation location,
+                         const clang::NamedDecl *ND,
+                         llvm::ArrayRef<clang::FixItHint> fixits,
+                         llvm::StringRef message,
+                         const clang::SourceManager &source_manager) {
+    idt::record record{finding};
+    record.unit = unit_;
+    record.message = message.str();
+
+    clang::PresumedLoc presumed =
+        source_manager.getPresumedLoc(source_manager.getExpansionLoc(location));
+    if (presumed.isValid()) {
+      record.file = presumed.getFilename();
+      record.line = presumed.getLine();
+      record.column = presumed.getColumn();
+    }
+
+    if (ND) {
+      record.name = ND->getQualifiedNameAsString();
+      llvm::SmallString<128> usr;
+      if (!clang::index::generateUSRForDecl(ND, usr))
+        record.usr = usr.str().str();
+    }
+
+    // The fix-its are located in the file to rewrite, even if they were
+    // suggested for a macro expansion.
+    if (lang_options_) {
+      for (const clang::FixItHint &hint : fixits) {
+        clang::CharSourceRange range = clang::Lexer::makeFileCharRange(
+            hint.RemoveRange, source_manager, *lang_options_);
+        if (range.isInvalid())
+          continue;
+        unsigned offset = source_manager.getFileOffset(range.getBegin());
+        record.fixits.push_back(idt::record::replacement{
+            source_manager.getFilename(range.getBegin()).str(), offset,
+            source_manager.getFileOffset(range.getEnd()) - offset,
+            hint.CodeToInsert});
+      }
+    }
+
+    return record;
+  }
+
+  void format(llvm::raw_ostream &OS, const idt::record &record) {
+    llvm::json::OStream J{OS};
+    if (format_ == idt::output_format::sarif) {
+      write_sarif(J, record);
+    } else {
+      write_jsonl(J, record);
+      OS << '\n';
+    }
   }
 };
 
@@ -167,15 +1234,34 @@ class consumer : public clang::ASTConsumer {
   };
 
   idt::visitor visitor_;
+  idt::inventory &inventory_;
+  idt::statistics::unit *statistics_;
+  idt::progress *progress_;
+  idt::buffered_consumer *recorder_;
+  bool client_;
 
   fixit_options options_;
   std::unique_ptr<clang::FixItRewriter> rewriter_;
 
 public:
-  explicit consumer(clang::ASTContext &context)
-      : visitor_(context) {}
+  explicit consumer(clang::ASTContext &context, idt::inventory &inventory,
+                    idt::statistics::unit *statistics,
+                    idt::progress *progress, idt::buffered_consumer *recorder,
+                    bool client, unsigned unit)
+      : visitor_(context, inventory, client, unit, recorder != nullptr),
+        inventory_(inventory), statistics_(statistics), progress_(progress),
+        recorder_(recorder), client_(client) {}
 
   void HandleTranslationUnit(clang::ASTContext &context) override {
+    if (statistics_)
+      statistics_->lap(idt::statistics::parse);
+
+    if (client_) {
+      inventory_.add_client();
+      traverse(context);
+      return;
+    }
+
     if (apply_fixits) {
       clang::DiagnosticsEngine &diagnostics_engine = context.getDiagnostics();
       rewriter_ =
@@ -186,27 +1272,171 @@ public:
       diagnostics_engine.setClient(rewriter_.get(), /*ShouldOwnClient=*/false);
     }
 
-    visitor_.TraverseDecl(context.getTranslationUnitDecl());
+    traverse(context);
 
-    if (apply_fixits)
+    if (apply_fixits) {
+      llvm::TimeTraceScope scope("Fix-its");
       rewriter_->WriteFixedFiles();
+      if (statistics_)
+        statistics_->lap(idt::statistics::fixits);
+    }
+  }
+
+private:
+  void traverse(clang::ASTContext &context) {
+    {
+      llvm::TimeTraceScope scope("Traverse");
+      visitor_.TraverseDecl(context.getTranslationUnitDecl());
+      if (recorder_)
+        recorder_->add(context, visitor_.recorded());
+    }
+
+    if (progress_)
+      progress_->traversed(visitor_.declarations());
+
+    if (!statistics_)
+      return;
+    statistics_->lap(idt::statistics::traverse);
+    statistics_->files = context.getSourceManager().fileinfo_size();
+    statistics_->declarations = visitor_.declarations();
+    statistics_->findings = visitor_.findings();
+    statistics_->functions = visitor_.functions();
+    statistics_->lookups = visitor_.lookups();
+    statistics_->hits = visitor_.hits();
+    statistics_->ast_memory = context.getASTAllocatedMemory() +
+                              context.getSideTableAllocatedMemory();
+    statistics_->peak_memory = get_peak_memory();
   }
 };
 
-struct action : clang::ASTFrontendAction {
+class action : public clang::ASTFrontendAction {
+  idt::inventory &inventory_;
+  idt::statistics *statistics_;
+  idt::progress *progress_;
+  idt::writer *writer_;
+  idt::buffered_consumer *buffered_ = nullptr;
+  idt::statistics::unit unit_;
+
+protected:
+  bool BeginInvocation(clang::CompilerInstance &CI) override {
+    if (statistics_)
+      unit_.start();
+    std::string path = get_normalized_path(CI.getFileManager(),
+                                           getCurrentFile());
+    if (progress_)
+      progress_->begin(path);
+    if (writer_) {
+      buffered_ = new idt::buffered_consumer(
+          *writer_, format, sort_findings, path, CI.getDiagnosticOpts());
+      CI.getDiagnostics().setClient(buffered_, /*ShouldOwnClient=*/true);
+    }
+    return true;
+  }
+
+  void ExecuteAction() override {
+    if (statistics_)
+      unit_.lap(idt::statistics::setup);
+    llvm::TimeTraceScope scope("Frontend", getCurrentFile());
+    clang::ASTFrontendAction::ExecuteAction();
+  }
+
+  void EndSourceFileAction() override {
+    if (statistics_)
+      statistics_->add(std::move(unit_));
+    if (progress_)
+      progress_->end();
+  }
+
+public:
+  explicit action(idt::inventory &inventory, idt::statistics *statistics,
+                  idt::progress *progress, idt::writer *writer)
+      : inventory_(inventory), statistics_(statistics), progress_(progress),
+        writer_(writer) {}
+
   std::unique_ptr<clang::ASTConsumer>
-  CreateASTConsumer(clang::CompilerInstance &CI, llvm::StringRef) override {
-    return std::make_unique<idt::consumer>(CI.getASTContext());
+  CreateASTConsumer(clang::CompilerInstance &CI,
+                    llvm::StringRef file) override {
+    std::string path = get_normalized_path(CI.getFileManager(), file);
+    unit_.path = path;
+    // Unless they are rendered as text or fixed, the findings bypass the
+    // diagnostics engine.
+    bool record = buffered_ && format != idt::output_format::text &&
+                  !apply_fixits;
+    return std::make_unique<idt::consumer>(
+        CI.getASTContext(), inventory_, statistics_ ? &unit_ : nullptr,
+        progress_, record ? buffered_ : nullptr, is_client(path),
+        inventory_.add_unit(std::move(path)));
   }
 };
 
-struct factory : clang::tooling::FrontendActionFactory {
+class factory : public clang::tooling::FrontendActionFactory {
+  idt::inventory &inventory_;
+  idt::statistics *statistics_;
+  idt::progress *progress_;
+  idt::writer *writer_;
+
+public:
+  explicit factory(idt::inventory &inventory, idt::statistics *statistics,
+                   idt::progress *progress, idt::writer *writer)
+      : inventory_(inventory), statistics_(statistics), progress_(progress),
+        writer_(writer) {}
+
   std::unique_ptr<clang::FrontendAction> create() override {
-    return std::make_unique<idt::action>();
+    return std::make_unique<idt::action>(inventory_, statistics_, progress_,
+                                         writer_);
   }
 };
 }
 
+namespace idt {
+// Runs `factory` over `sources` on `jobs` workers, each repeatedly claiming
+// the next file.  Every worker has its own lane in the time trace.
+int run(const clang::tooling::CompilationDatabase &compilations,
+        const std::vector<std::string> &sources,
+        clang::tooling::FrontendActionFactory &factory, unsigned jobs) {
+  using namespace clang::tooling;
+
+  if (jobs == 1) {
+    ClangTool tool{compilations, sources};
+    return tool.run(&factory);
+  }
+
+  std::atomic<size_t> next{0};
+  std::atomic<int> result{0};
+  auto worker = [&](unsigned index) {
+    idt::worker = index;
+    llvm::set_thread_name("idt worker " + llvm::Twine(index));
+    if (!time_trace.empty())
+      llvm::timeTraceProfilerInitialize(time_trace_granularity, "idt");
+
+    for (size_t file = next++; file < sources.size(); file = next++) {
+      llvm::TimeTraceScope scope("Translation unit", sources[file]);
+      // The tool changes the working directory of its file system, which
+      // must not be the one shared with the process and the other workers.
+      ClangTool tool{compilations, {sources[file]},
+                     std::make_shared<clang::PCHContainerOperations>(),
+                     llvm::vfs::createPhysicalFileSystem()};
+      // A failure (1) takes precedence over a skipped file (2).
+      int status = tool.run(&factory);
+      int expected = result.load();
+      while ((status == 1 || expected == 0) &&
+             !result.compare_exchange_weak(expected, status))
+        ;
+    }
+
+    if (!time_trace.empty())
+      llvm::timeTraceProfilerFinishThread();
+  };
+
+  std::vector<std::thread> workers;
+  for (unsigned index = 0; index < jobs; ++index)
+    workers.emplace_back(worker, index);
+  for (auto &worker : workers)
+    worker.join();
+  return result;
+}
+}
+
 int main(int argc, char *argv[]) {
   using namespace clang::tooling;
 
@@ -214,8 +1444,138 @@ int main(int argc, char *argv[]) {
       CommonOptionsParser::create(argc, const_cast<const char **>(argv),
                                   idt::category, llvm::cl::OneOrMore);
   if (options) {
-    ClangTool tool{options->getCompilations(), options->getSourcePathList()};
-    return tool.run(new idt::factory{});
+    idt::resolve_inputs();
+
+    auto budgets = get_export_budgets();
+    if (!budgets) {
+      llvm::logAllUnhandledErrors(budgets.takeError(), llvm::errs(),
+                                  "error: ");
+      return EXIT_FAILURE;
+    }
+
+    std::vector<std::string> sources = options->getSourcePathList();
+    sources.insert(sources.end(), idt::clients.begin(), idt::clients.end());
+
+    // Fix-its rewrite headers shared between translation units, so only a
+    // single worker may apply them.
+    unsigned workers = jobs;
+    if (workers == 0)
+      workers = llvm::hardware_concurrency().compute_thread_count();
+    if (workers > 1 && apply_fixits) {
+      llvm::errs() << "warning: fix-its are applied with a single worker\n";
+      workers = 1;
+    }
+
+    if (!time_trace.empty())
+      llvm::timeTraceProfilerInitialize(time_trace_granularity, "idt");
+
+    // The visitor only collects the declarations when a report reads them.
+    idt::inventory inventory{export_report || !max_exports.empty() ||
+                             !binaries.empty() || !idt::clients.empty() ||
+                             !emit_module_definition.empty() ||
+                             !emit_version_script.empty() ||
+                             !snapshot.empty()};
+    idt::statistics statistics;
+    bool collect_statistics = print_statistics || !stats_file.empty();
+    std::optional<idt::progress> progress;
+    if (show_progress) {
+      progress.emplace(sources, workers);
+      // Redraw a terminal frequently, but keep logs readable.
+      progress->start(llvm::sys::Process::StandardErrIsDisplayed()
+                          ? std::chrono::milliseconds(250)
+                          : std::chrono::milliseconds(10000));
+    }
+    // Concurrent workers write their output through a single writer, as do
+    // the machine-readable formats and the sorted findings.  The writer also
+    // keeps the remarks from racing with the progress on stderr.
+    std::optional<idt::writer> writer;
+    if (workers > 1 || format != idt::output_format::text || sort_findings ||
+        progress)
+      writer.emplace(llvm::outs(), llvm::errs(),
+                     progress ? &*progress : nullptr, format, sort_findings,
+                     size_t(sort_memory) << 20);
+    idt::factory factory{inventory,
+                         collect_statistics ? &statistics : nullptr,
+                         progress ? &*progress : nullptr,
+                         writer ? &*writer : nullptr};
+    int result =
+        idt::run(options->getCompilations(), sources, factory, workers);
+    // The workers are done, so the final progress precedes whatever the
+    // writer has yet to write.
+    if (progress)
+      progress->stop();
+    if (writer)
+      writer->close();
+
+    if (!time_trace.empty()) {
+      if (auto error = llvm::timeTraceProfilerWrite(time_trace, "idt")) {
+        llvm::logAllUnhandledErrors(std::move(error), llvm::errs(),
+                                    "error: " + time_trace + ": ");
+        result = EXIT_FAILURE;
+      }
+      llvm::timeTraceProfilerCleanup();
+    }
+
+    if (print_statistics)
+      statistics.print(llvm::errs());
+    if (!stats_file.empty()) {
+      std::error_code error;
+      llvm::raw_fd_ostream OS{stats_file, error, llvm::sys::fs::OF_Text};
+      if (error) {
+        llvm::errs() << "error: unable to write '" << stats_file
+                     << "': " << error.message() << "\n";
+        result = EXIT_FAILURE;
+      } else {
+        statistics.write(OS);
+      }
+    }
+
+    if (export_report)
+      inventory.report(llvm::outs());
+    if (!inventory.check(*budgets, llvm::errs()))
+      result = EXIT_FAILURE;
+
+    for (const auto &binary : binaries) {
+      auto exports = idt::read_exports(binary);
+      if (!exports) {
+        llvm::logAllUnhandledErrors(exports.takeError(), llvm::errs(),
+                                    "error: " + binary + ": ");
+        result = EXIT_FAILURE;
+        continue;
+      }
+      inventory.cross_check(binary, *exports, llvm::outs());
+    }
+
+    if (!idt::clients.empty())
+      inventory.report_unused(llvm::outs());
+
+    if (idt::extern_templates)
+      inventory.report_instantiations(llvm::outs());
+
+    if (idt::inline_data_access)
+      inventory.report_data_accesses(llvm::outs());
+
+    if (idt::internal_linkage)
+      inventory.report_linkage(llvm::outs());
+
+    if (!emit_module_definition.empty()) {
+      // Regenerating the module-definition file preserves its ordinals.
+      std::map<std::string, unsigned> ordinals =
+          idt::read_ordinals(emit_module_definition);
+      auto write = [&ordinals](llvm::raw_ostream &OS, const auto &symbols) {
+        idt::write_module_definition(OS, symbols, ordinals);
+      };
+      if (!idt::write_interface(emit_module_definition, inventory, write))
+        result = EXIT_FAILURE;
+    }
+    if (!emit_version_script.empty() &&
+        !idt::write_interface(emit_version_script, inventory,
+                              idt::write_version_script))
+      result = EXIT_FAILURE;
+    if (!snapshot.empty() && !idt::write_snapshot(snapshot, inventory))
+      result = EXIT_FAILURE;
+
+    return result;
   } else {
     llvm::logAllUnhandledErrors(std::move(options.takeError()), llvm::errs());
     return EXIT_FAILURE;
@@ -0,0 +1,842 @@
+// Copyright (c) 2021 Saleem Abdulrasool.  All Rights Reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "scanner.hh"
+
+#include "llvm/ADT/StringSwitch.h"
+#include "llvm/Demangle/Demangle.h"
+#include "llvm/Object/Archive.h"
+#include "llvm/Object/COFF.h"
+#include "llvm/Object/COFFImportFile.h"
+#include "llvm/Object/ELFObjectFile.h"
+#include "llvm/Object/MachO.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/Path.h"
+
+#include <algorithm>
+#include <tuple>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <time.h>
+#endif
+
+namespace idt {
+llvm::cl::OptionCategory category{"interface definition scanner options"};
+
+llvm::cl::opt<std::string>
+export_macro("export-macro",
+             llvm::cl::desc("The macro to decorate interfaces with"),
+             llvm::cl::value_desc("define"), llvm::cl::Required,
+             llvm::cl::cat(idt::category));
+
+llvm::cl::list<std::string>
+clients("client",
+        llvm::cl::desc("Scan a consumer of the library for references to its exports"),
+        llvm::cl::value_desc("path"),
+        llvm::cl::cat(idt::category));
+
+llvm::cl::opt<bool>
+extern_templates("extern-templates", llvm::cl::init(false),
+                 llvm::cl::desc("Recommend extern templates for frequently instantiated templates"),
+                 llvm::cl::cat(idt::category));
+
+llvm::cl::opt<bool>
+inline_data_access("inline-data-access", llvm::cl::init(false),
+                   llvm::cl::desc("Report inline functions which access imported data"),
+                   llvm::cl::cat(idt::category));
+
+llvm::cl::opt<bool>
+internal_linkage("internal-linkage", llvm::cl::init(false),
+                 llvm::cl::desc("Suggest internal linkage for header declarations used by a single translation unit"),
+                 llvm::cl::cat(idt::category));
+
+namespace {
+llvm::cl::list<std::string>
+ignored_functions("ignore",
+                  llvm::cl::desc("Ignore one or more functions or variables"),
+                  llvm::cl::value_desc("function-name[,function-name...]"),
+                  llvm::cl::CommaSeparated,
+                  llvm::cl::cat(idt::category));
+
+llvm::cl::list<std::string>
+library_directories("library",
+                    llvm::cl::desc("Attribute the headers in a directory to a library"),
+                    llvm::cl::value_desc("name=directory"),
+                    llvm::cl::cat(idt::category));
+
+llvm::cl::opt<unsigned>
+extern_template_threshold("extern-template-threshold", llvm::cl::init(2),
+                          llvm::cl::desc("The number of translation units instantiating a template to recommend an extern template"),
+                          llvm::cl::value_desc("count"),
+                          llvm::cl::cat(idt::category));
+
+llvm::cl::opt<unsigned>
+extern_template_limit("extern-template-limit", llvm::cl::init(10),
+                      llvm::cl::desc("The number of extern templates to recommend"),
+                      llvm::cl::value_desc("count"),
+                      llvm::cl::cat(idt::category));
+
+llvm::cl::opt<unsigned>
+stats_slowest("stats-slowest", llvm::cl::init(10),
+              llvm::cl::desc("The number of slowest and largest translation units to list with -statistics"),
+              llvm::cl::value_desc("count"),
+              llvm::cl::cat(idt::category));
+
+struct library {
+  std::string name;
+  std::string directory;
+};
+
+std::set<std::string> resolved_clients;
+std::vector<library> resolved_libraries;
+
+// Symbols which the linker synthesizes rather than any declaration.
+bool is_linker_symbol(llvm::StringRef name) {
+  return llvm::StringSwitch<bool>(name)
+      .Cases("_init", "_fini", "_edata", "_end", "__bss_start", true)
+      .Cases("_DYNAMIC", "_GLOBAL_OFFSET_TABLE_", "_PROCEDURE_LINKAGE_TABLE_",
+             true)
+      .Default(false);
+}
+
+// Symbols with vague linkage, which any translation unit that needs them
+// emits: vtables, type information, guard variables, thunks and the helpers
+// which the Microsoft ABI synthesizes for classes.  A binary exports them
+// without any declaration of the interface accounting for them.
+bool is_vague_linkage_symbol(llvm::StringRef name) {
+  // Mach-O prefixes C and Itanium symbols with an underscore.
+  if (name.starts_with("__Z"))
+    name = name.drop_front();
+  if (name.consume_front("_Z"))
+    return llvm::StringSwitch<bool>(name)
+        .StartsWith("TV", true)   // vtable
+        .StartsWith("TI", true)   // type information
+        .StartsWith("TS", true)   // type information name
+        .StartsWith("TT", true)   // VTT
+        .StartsWith("TC", true)   // construction vtable
+        .StartsWith("Th", true)   // non-virtual thunk
+        .StartsWith("Tv", true)   // virtual thunk
+        .StartsWith("Tc", true)   // covariant thunk
+        .StartsWith("TH", true)   // thread-local initializer
+        .StartsWith("TW", true)   // thread-local wrapper
+        .StartsWith("GV", true)   // guard variable
+        .Default(false);
+  return llvm::StringSwitch<bool>(name)
+      .StartsWith("??_7", true)   // vftable
+      .StartsWith("??_8", true)   // vbtable
+      .StartsWith("??_9", true)   // vcall thunk
+      .StartsWith("??_D", true)   // vbase destructor
+      .StartsWith("??_E", true)   // vector deleting destructor
+      .StartsWith("??_F", true)   // default constructor closure
+      .StartsWith("??_G", true)   // scalar deleting destructor
+      .StartsWith("??_O", true)   // copy constructor closure
+      .StartsWith("??_R", true)   // RTTI
+      .Default(false);
+}
+
+// Collects the symbols which a `.drectve` section of an object file exports
+// (e.g. `/EXPORT:symbol,DATA`).
+void collect_directive_exports(llvm::StringRef directives,
+                               std::set<std::string> &exports) {
+  llvm::SmallVector<llvm::StringRef, 8> arguments;
+  directives.split(arguments, ' ', /*MaxSplit=*/-1, /*KeepEmpty=*/false);
+  for (llvm::StringRef argument : arguments) {
+    if (!argument.consume_front_insensitive("/export:") &&
+        !argument.consume_front_insensitive("-export:"))
+      continue;
+    argument = argument.split(',').first.trim('"');
+    if (!argument.empty())
+      exports.insert(argument.str());
+  }
+}
+
+llvm::Error collect_exports(const llvm::object::Binary &binary,
+                            export_table &exports);
+
+llvm::Error collect_exports(const llvm::object::Archive &archive,
+                            export_table &exports) {
+  llvm::Error error = llvm::Error::success();
+  for (const auto &child : archive.children(error)) {
+    llvm::Expected<std::unique_ptr<llvm::object::Binary>> member =
+        child.getAsBinary();
+    if (!member) {
+      // Skip members which are not object files (e.g. the string table).
+      llvm::consumeError(member.takeError());
+      continue;
+    }
+    if (llvm::Error member_error = collect_exports(**member, exports)) {
+      llvm::consumeError(std::move(error));
+      return member_error;
+    }
+  }
+  return error;
+}
+
+llvm::Error collect_exports(const llvm::object::Binary &binary,
+                            export_table &exports) {
+  using namespace llvm::object;
+
+  if (const auto *archive = llvm::dyn_cast<Archive>(&binary))
+    return collect_exports(*archive, exports);
+
+  // Import libraries describe each import as a short import member, which
+  // defines the `__imp_` prefixed pointer and (for functions) a thunk.
+  if (const auto *import = llvm::dyn_cast<COFFImportFile>(&binary)) {
+    for (const BasicSymbolRef &symbol : import->symbols()) {
+      std::string name;
+      llvm::raw_string_ostream OS{name};
+      if (llvm::Error error = symbol.printName(OS))
+        return error;
+      OS.flush();
+      if (llvm::StringRef(name).starts_with("__imp_"))
+        exports.symbols.insert(name.substr(6));
+    }
+    return llvm::Error::success();
+  }
+
+  if (const auto *coff = llvm::dyn_cast<COFFObjectFile>(&binary)) {
+    for (const ExportDirectoryEntryRef &entry : coff->export_directories()) {
+      llvm::StringRef name;
+      if (llvm::Error error = entry.getSymbolName(name))
+        return error;
+      if (!name.empty())
+        exports.symbols.insert(name.str());
+    }
+
+    for (const SectionRef &section : coff->sections()) {
+      llvm::Expected<llvm::StringRef> name = section.getName();
+      if (!name)
+        return name.takeError();
+      if (*name != ".drectve")
+        continue;
+
+      llvm::Expected<llvm::StringRef> contents = section.getContents();
+      if (!contents)
+        return contents.takeError();
+      collect_directive_exports(*contents, exports.symbols);
+    }
+    return llvm::Error::success();
+  }
+
+  if (const auto *macho = llvm::dyn_cast<MachOObjectFile>(&binary)) {
+    if (macho->getHeader().filetype == llvm::MachO::MH_DYLIB) {
+      llvm::Error error = llvm::Error::success();
+      for (const ExportEntry &entry : macho->exports(error)) {
+        exports.symbols.insert(entry.name().str());
+        if (entry.flags() & llvm::MachO::EXPORT_SYMBOL_FLAGS_WEAK_DEFINITION)
+          exports.weak.insert(entry.name().str());
+      }
+      return error;
+    }
+  }
+
+  const auto *object = llvm::dyn_cast<ObjectFile>(&binary);
+  if (!object)
+    return llvm::Error::success();
+
+  auto collect = [&exports](const SymbolRef &symbol) -> llvm::Error {
+    llvm::Expected<uint32_t> flags = symbol.getFlags();
+    if (!flags)
+      return flags.takeError();
+    if (!(*flags & SymbolRef::SF_Global) ||
+        (*flags & (SymbolRef::SF_Undefined | SymbolRef::SF_Hidden)))
+      return llvm::Error::success();
+
+    llvm::Expected<llvm::StringRef> name = symbol.getName();
+    if (!name)
+      return name.takeError();
+    if (is_linker_symbol(*name))
+      return llvm::Error::success();
+    exports.symbols.insert(name->str());
+    if (*flags & SymbolRef::SF_Weak)
+      exports.weak.insert(name->str());
+    return llvm::Error::success();
+  };
+
+  // Shared objects export their dynamic symbol table; relocatable objects
+  // (e.g. members of a static archive) export their default visibility
+  // global symbols.
+  if (const auto *elf = llvm::dyn_cast<ELFObjectFileBase>(object)) {
+    if (elf->getEType() == llvm::ELF::ET_DYN) {
+      for (const ELFSymbolRef &symbol : elf->getDynamicSymbolIterators())
+        if (llvm::Error error = collect(symbol))
+          return error;
+      return llvm::Error::success();
+    }
+  }
+
+  for (const SymbolRef &symbol : object->symbols())
+    if (llvm::Error error = collect(symbol))
+      return error;
+  return llvm::Error::success();
+}
+
+// The export surface of all the declarations attributed to a header or a
+// library, indexed by `idt::kind` and `idt::exposure`.
+struct surface {
+  std::array<std::array<unsigned, 3>, 3> counts{};
+  unsigned inline_functions = 0;
+  unsigned inline_symbols = 0;
+
+  unsigned &operator()(idt::kind kind, idt::exposure exposure) {
+    return counts[static_cast<unsigned>(kind)][static_cast<unsigned>(exposure)];
+  }
+
+  unsigned exports() const {
+    unsigned total = 0;
+    for (const auto &kind : counts)
+      total += kind[static_cast<unsigned>(exposure::exported)] +
+               kind[static_cast<unsigned>(exposure::exported_private)];
+    return total;
+  }
+
+  void print(llvm::raw_ostream &OS) const {
+    static const char * const kKinds[] = {
+      "functions", "variables", "classes",
+    };
+    for (unsigned kind = 0; kind < counts.size(); ++kind)
+      OS << "  " << kKinds[kind] << ": "
+         << counts[kind][static_cast<unsigned>(exposure::exported)]
+         << " exported, "
+         << counts[kind][static_cast<unsigned>(exposure::unexported_public)]
+         << " unexported public, "
+         << counts[kind][static_cast<unsigned>(exposure::exported_private)]
+         << " exported private\n";
+    if (inline_functions)
+      OS << "  exported inline functions: " << inline_functions << " ("
+         << inline_symbols << " symbols could be saved)\n";
+  }
+
+};
+}
+
+const std::set<std::string> &get_ignored_functions() {
+  static auto kIgnoredFunctions = [&]() -> std::set<std::string> {
+      return { ignored_functions.begin(), ignored_functions.end() };
+    }();
+
+  return kIgnoredFunctions;
+}
+
+std::string get_normalized_path(llvm::StringRef path) {
+  llvm::SmallString<256> normalized{path};
+  llvm::sys::fs::make_absolute(normalized);
+  llvm::sys::path::remove_dots(normalized, /*remove_dot_dot=*/true);
+  return std::string(normalized);
+}
+
+std::string get_normalized_path(const clang::FileManager &file_manager,
+                                llvm::StringRef path) {
+  llvm::SmallString<256> normalized{path};
+  file_manager.makeAbsolutePath(normalized);
+  llvm::sys::path::remove_dots(normalized, /*remove_dot_dot=*/true);
+  return std::string(normalized);
+}
+
+void resolve_inputs() {
+  for (const auto &client : clients)
+    resolved_clients.insert(get_normalized_path(client));
+  for (const auto &specification : library_directories) {
+    auto [name, directory] = llvm::StringRef(specification).split('=');
+    resolved_libraries.push_back({name.str(), get_normalized_path(directory)});
+  }
+}
+
+bool is_client(llvm::StringRef path) {
+  return contains(resolved_clients, path.str());
+}
+
+std::optional<std::string> get_library(llvm::StringRef path) {
+  if (resolved_libraries.empty())
+    return export_macro.getValue();
+
+  const library *match = nullptr;
+  for (const auto &library : resolved_libraries) {
+    llvm::StringRef directory{library.directory};
+    if (!path.starts_with(directory))
+      continue;
+    if (path.size() > directory.size() &&
+        !llvm::sys::path::is_separator(path[directory.size()]))
+      continue;
+    if (!match || directory.size() > match->directory.size())
+      match = &library;
+  }
+  if (!match)
+    return std::nullopt;
+  return match->name;
+}
+
+bool is_library(llvm::StringRef name) {
+  if (resolved_libraries.empty())
+    return name == export_macro.getValue();
+  return llvm::any_of(resolved_libraries, [name](const library &library) {
+    return library.name == name;
+  });
+}
+
+llvm::Expected<export_table> read_exports(llvm::StringRef path) {
+  llvm::Expected<llvm::object::OwningBinary<llvm::object::Binary>> binary =
+      llvm::object::createBinary(path);
+  if (!binary)
+    return binary.takeError();
+
+  export_table exports;
+  if (llvm::Error error = collect_exports(*binary->getBinary(), exports))
+    return std::move(error);
+  return exports;
+}
+
+void inventory::report(llvm::raw_ostream &OS) const {
+  std::map<std::string, surface> libraries;
+  std::map<std::pair<std::string, std::string>, surface> headers;
+  for (const auto &entry : entries_) {
+    const auto &value = entry.getValue();
+    // The members of a class which is to be exported as a whole are counted
+    // with the class.
+    if (value.class_member)
+      continue;
+    for (surface *totals : { &libraries[value.library],
+                             &headers[{value.path, value.library}] }) {
+      (*totals)(value.kind, value.exposure)++;
+      if (value.inline_function) {
+        ++totals->inline_functions;
+        totals->inline_symbols += value.symbols.size();
+      }
+    }
+  }
+
+  for (const auto &library : libraries) {
+    OS << "library '" << library.first << "': "
+       << library.second.exports() << " exported symbols\n";
+    library.second.print(OS);
+  }
+  for (const auto &header : headers) {
+    OS << "header '" << header.first.first << "' (library '"
+       << header.first.second << "'): " << header.second.exports()
+       << " exported symbols\n";
+    header.second.print(OS);
+  }
+}
+
+bool inventory::check(const std::map<std::string, unsigned> &budgets,
+                      llvm::raw_ostream &OS) const {
+  std::map<std::string, surface> libraries;
+  for (const auto &entry : entries_)
+    libraries[entry.getValue().library](entry.getValue().kind,
+                                        entry.getValue().exposure)++;
+
+  bool within_budget = true;
+  for (const auto &library : libraries) {
+    auto budget = budgets.find(library.first);
+    if (budget == budgets.end())
+      budget = budgets.find("");
+    if (budget == budgets.end())
+      continue;
+
+    unsigned exports = library.second.exports();
+    if (exports <= budget->second)
+      continue;
+
+    OS << "error: library '" << library.first << "' exports " << exports
+       << " symbols, exceeding the budget of " << budget->second << "\n";
+    within_budget = false;
+  }
+  return within_budget;
+}
+
+void inventory::cross_check(llvm::StringRef binary,
+                            const export_table &exports,
+                            llvm::raw_ostream &OS) const {
+  std::set<llvm::StringRef> declared;
+  for (const auto &entry : entries_)
+    declared.insert(entry.getValue().symbols.begin(),
+                    entry.getValue().symbols.end());
+
+  // Symbols with vague linkage are exported by whichever binary emits them,
+  // and are not over-exported interfaces.
+  std::vector<llvm::StringRef> over_exported;
+  for (const auto &symbol : exports.symbols)
+    if (!idt::contains(declared, llvm::StringRef(symbol)) &&
+        !idt::contains(exports.weak, symbol) &&
+        !idt::contains(implicit_, symbol) && !is_vague_linkage_symbol(symbol))
+      over_exported.push_back(symbol);
+
+  std::vector<const entry *> missing;
+  for (const auto &entry : entries_) {
+    const auto &value = entry.getValue();
+    if (value.exposure == exposure::unexported_public ||
+        value.symbols.empty())
+      continue;
+    if (llvm::none_of(value.symbols, [&](const std::string &symbol) {
+          return exports.symbols.count(symbol);
+        }))
+      missing.push_back(&value);
+  }
+  llvm::sort(missing, [](const entry *lhs, const entry *rhs) {
+    return std::tie(lhs->path, lhs->line, lhs->name) <
+           std::tie(rhs->path, rhs->line, rhs->name);
+  });
+
+  OS << "binary '" << binary << "': " << exports.symbols.size()
+     << " exported symbols, " << over_exported.size() << " over-exported, "
+     << missing.size() << " missing\n";
+  for (llvm::StringRef symbol : over_exported)
+    OS << "  over-exported symbol '" << llvm::demangle(symbol.str())
+       << "' (" << symbol << ") is not declared by any header\n";
+  for (const entry *entry : missing)
+    OS << "  missing symbol '" << entry->name << "' ("
+       << entry->symbols.front() << ") declared at " << entry->path << ":"
+       << entry->line << "\n";
+}
+
+std::vector<std::pair<std::string, idt::kind>>
+inventory::interface(llvm::StringRef library) const {
+  std::vector<std::pair<std::string, idt::kind>> symbols;
+  for (const auto &entry : entries_) {
+    const auto &value = entry.getValue();
+    if (!library.empty() && value.library != library)
+      continue;
+    if (value.exposure == exposure::exported_private ||
+        value.inline_function)
+      continue;
+    for (const auto &symbol : value.symbols)
+      symbols.emplace_back(symbol, value.kind);
+  }
+  llvm::sort(symbols);
+  symbols.erase(std::unique(symbols.begin(), symbols.end()), symbols.end());
+  return symbols;
+}
+
+void inventory::report_instantiations(llvm::raw_ostream &OS) const {
+  std::vector<const instantiation *> candidates;
+  for (const auto &instantiation : instantiations_)
+    if (instantiation.getValue().units >= extern_template_threshold)
+      candidates.push_back(&instantiation.getValue());
+  llvm::sort(candidates,
+             [](const instantiation *lhs, const instantiation *rhs) {
+               if (lhs->units != rhs->units)
+                 return lhs->units > rhs->units;
+               return lhs->declaration < rhs->declaration;
+             });
+  if (candidates.size() > extern_template_limit)
+    candidates.resize(extern_template_limit);
+
+  for (const instantiation *candidate : candidates) {
+    std::string declaration =
+        candidate->key.empty()
+            ? export_macro + " " + candidate->declaration
+            : candidate->key + " " + export_macro + " " +
+                  candidate->declaration.substr(candidate->key.size() + 1);
+    OS << "template '" << candidate->declaration
+       << "' is implicitly instantiated in " << candidate->units
+       << " translation units\n"
+       << "  header: extern template " << declaration << ";\n"
+       << "  source: template " << declaration << ";\n";
+    if (candidate->path.empty())
+      continue;
+
+    OS << "fix-it:\"";
+    OS.write_escaped(candidate->path);
+    OS << "\":{" << candidate->line << ":" << candidate->column << "-"
+       << candidate->line << ":" << candidate->column << "}:\"";
+    OS.write_escaped("\nextern template " + declaration + ";");
+    OS << "\"\n";
+  }
+}
+
+void inventory::report_data_accesses(llvm::raw_ostream &OS) const {
+  std::vector<const data_access *> accesses;
+  for (const auto &access : data_accesses_)
+    accesses.push_back(&access.getValue());
+  llvm::sort(accesses, [](const data_access *lhs, const data_access *rhs) {
+    if (lhs->units != rhs->units)
+      return lhs->units > rhs->units;
+    return std::tie(lhs->path, lhs->line, lhs->name) <
+           std::tie(rhs->path, rhs->line, rhs->name);
+  });
+
+  for (const data_access *access : accesses) {
+    OS << "inline function '" << access->name << "' at " << access->path
+       << ":" << access->line << " accesses imported data ";
+    llvm::interleaveComma(access->variables, OS,
+                          [&](const std::string &variable) {
+                            OS << "'" << variable << "'";
+                          });
+    OS << " and is used in " << access->units << " translation units\n";
+  }
+}
+
+void inventory::report_linkage(llvm::raw_ostream &OS) const {
+  std::vector<const linkage *> candidates;
+  for (const auto &linkage : linkages_) {
+    const auto &value = linkage.getValue();
+    if (value.exported || value.definitions.size() != 1 ||
+        value.uses.empty())
+      continue;
+    if (llvm::all_of(value.uses, [&](unsigned unit) {
+          return unit == value.definitions.front();
+        }))
+      candidates.push_back(&value);
+  }
+  llvm::sort(candidates, [](const linkage *lhs, const linkage *rhs) {
+    return std::tie(lhs->path, lhs->line, lhs->name) <
+           std::tie(rhs->path, rhs->line, rhs->name);
+  });
+
+  for (const linkage *candidate : candidates)
+    OS << "'" << candidate->name << "' declared at " << candidate->path
+       << ":" << candidate->line
+       << " is only referenced from its defining translation unit '"
+       << units_[candidate->definitions.front()]
+       << "'; consider internal linkage or a private header\n";
+}
+
+void inventory::write_snapshot(llvm::raw_ostream &OS) const {
+  static const char * const kKinds[] = { "function", "variable", "class" };
+
+  std::vector<const llvm::StringMapEntry<entry> *> exports;
+  for (const auto &entry : entries_)
+    if (entry.getValue().exposure != exposure::unexported_public)
+      exports.push_back(&entry);
+  llvm::sort(exports, [](const llvm::StringMapEntry<entry> *lhs,
+                         const llvm::StringMapEntry<entry> *rhs) {
+    return lhs->getKey() < rhs->getKey();
+  });
+
+  OS << "# idt snapshot 1\n";
+  for (const auto *entry : exports) {
+    const auto &value = entry->getValue();
+    OS << entry->getKey() << '\t'
+       << kKinds[static_cast<unsigned>(value.kind)] << '\t' << value.name
+       << '\t' << value.signature << '\t'
+       << (value.attributes.empty() ? "-" : value.attributes) << '\n';
+  }
+}
+
+void inventory::report_unused(llvm::raw_ostream &OS) const {
+  unsigned exports = 0;
+  std::vector<const entry *> unused;
+  for (const auto &entry : entries_) {
+    const auto &value = entry.getValue();
+    if (value.exposure != exposure::exported || value.kind == kind::record)
+      continue;
+    ++exports;
+    if (references_.find(entry.getKey()) == references_.end())
+      unused.push_back(&value);
+  }
+  llvm::sort(unused, [](const entry *lhs, const entry *rhs) {
+    return std::tie(lhs->path, lhs->line, lhs->name) <
+           std::tie(rhs->path, rhs->line, rhs->name);
+  });
+
+  for (const entry *entry : unused)
+    OS << "unused export '" << entry->name << "' declared at "
+       << entry->path << ":" << entry->line
+       << " is not referenced by any client\n";
+  OS << unused.size() << " of " << exports
+     << " exports are not referenced by any of " << clients_
+     << " clients\n";
+}
+
+size_t get_peak_memory() {
+#if defined(_WIN32)
+  PROCESS_MEMORY_COUNTERS counters;
+  if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    return 0;
+  return counters.PeakWorkingSetSize;
+#else
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage))
+    return 0;
+#if defined(__APPLE__)
+  return usage.ru_maxrss;
+#else
+  return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+double get_thread_cpu_time() {
+#if defined(_WIN32)
+  FILETIME creation, exit, kernel, user;
+  if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user))
+    return 0;
+  // FILETIMEs count 100ns intervals.
+  auto seconds = [](const FILETIME &time) {
+    ULARGE_INTEGER value;
+    value.LowPart = time.dwLowDateTime;
+    value.HighPart = time.dwHighDateTime;
+    return static_cast<double>(value.QuadPart) * 1e-7;
+  };
+  return seconds(kernel) + seconds(user);
+#else
+  struct timespec time;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time))
+    return 0;
+  return static_cast<double>(time.tv_sec) +
+         static_cast<double>(time.tv_nsec) * 1e-9;
+#endif
+}
+
+void statistics::print(llvm::raw_ostream &OS) const {
+  static const char * const kPhases[] = {
+    "setup", "parse", "traverse", "fix-its",
+  };
+
+  std::array<duration, phases> times{};
+  unsigned files = 0, declarations = 0, findings = 0;
+  for (const unit &unit : units_) {
+    for (unsigned phase = 0; phase < phases; ++phase)
+      times[phase] += unit.times[phase];
+    files += unit.files;
+    declarations += unit.declarations;
+    findings += unit.findings;
+  }
+
+  OS << "idt statistics: " << units_.size() << " translation units, "
+     << files << " files read, " << declarations << " declarations, "
+     << findings << " findings\n"
+     << llvm::format("  %-10s %10s %10s\n", "phase", "wall", "cpu");
+  duration total;
+  for (unsigned phase = 0; phase < phases; ++phase) {
+    OS << llvm::format("  %-10s %9.3fs %9.3fs\n", kPhases[phase],
+                       times[phase].wall, times[phase].cpu);
+    total += times[phase];
+  }
+  OS << llvm::format("  %-10s %9.3fs %9.3fs\n", "total", total.wall,
+                     total.cpu);
+
+  size_t peak_memory = 0;
+  for (const unit &unit : units_)
+    peak_memory = std::max(peak_memory, unit.peak_memory);
+  OS << llvm::format("  peak memory: %.1f MiB\n", mebibytes(peak_memory));
+
+  unsigned lookups = 0, hits = 0;
+  for (const unit &unit : units_) {
+    lookups += unit.lookups;
+    hits += unit.hits;
+  }
+  OS << "  inventory: " << lookups << " lookups, " << hits << " hits\n";
+
+  std::array<unsigned, outcomes> functions = count_functions();
+  OS << "function declarations:\n";
+  for (unsigned outcome = 0; outcome < outcomes; ++outcome)
+    OS << llvm::format("  %-18s %10u\n", kOutcomes[outcome],
+                       functions[outcome]);
+
+  std::vector<const unit *> slowest;
+  for (const unit &unit : units_)
+    slowest.push_back(&unit);
+  llvm::sort(slowest, [](const unit *lhs, const unit *rhs) {
+    return lhs->wall() > rhs->wall();
+  });
+  if (slowest.size() > stats_slowest)
+    slowest.resize(stats_slowest);
+  if (slowest.empty())
+    return;
+
+  OS << "slowest translation units:\n";
+  for (const unit *unit : slowest) {
+    OS << llvm::format("  %9.3fs ", unit->wall()) << unit->path << " (";
+    for (unsigned phase = 0; phase < phases; ++phase)
+      OS << (phase ? ", " : "") << kPhases[phase]
+         << llvm::format(" %.3fs", unit->times[phase].wall);
+    OS << "; " << unit->declarations << " declarations, "
+       << unit->findings << " findings)\n";
+  }
+
+  std::vector<const unit *> largest;
+  for (const unit &unit : units_)
+    largest.push_back(&unit);
+  llvm::sort(largest, [](const unit *lhs, const unit *rhs) {
+    return lhs->ast_memory > rhs->ast_memory;
+  });
+  if (largest.size() > stats_slowest)
+    largest.resize(stats_slowest);
+
+  OS << "largest translation units:\n";
+  for (const unit *unit : largest)
+    OS << llvm::format("  %9.1f MiB ", mebibytes(unit->ast_memory))
+       << unit->path
+       << llvm::format(" (AST; peak memory %.1f MiB)\n",
+                       mebibytes(unit->peak_memory));
+}
+
+void statistics::write(llvm::raw_ostream &OS) const {
+  static const char * const kPhases[] = {
+    "setup", "parse", "traverse", "fixits",
+  };
+
+  std::array<duration, phases> times{};
+  unsigned files = 0, declarations = 0, findings = 0;
+  unsigned lookups = 0, hits = 0;
+  size_t peak_memory = 0;
+  for (const unit &unit : units_) {
+    for (unsigned phase = 0; phase < phases; ++phase)
+      times[phase] += unit.times[phase];
+    files += unit.files;
+    declarations += unit.declarations;
+    findings += unit.findings;
+    lookups += unit.lookups;
+    hits += unit.hits;
+    peak_memory = std::max(peak_memory, unit.peak_memory);
+  }
+
+  llvm::json::OStream J{OS, /*IndentSize=*/2};
+  J.object([&] {
+    J.attribute("translation_units", static_cast<int64_t>(units_.size()));
+    J.attribute("files", files);
+    J.attribute("declarations", declarations);
+    J.attribute("findings", findings);
+    J.attribute("peak_memory", static_cast<int64_t>(peak_memory));
+    J.attributeObject("inventory", [&] {
+      J.attribute("lookups", lookups);
+      J.attribute("hits", hits);
+    });
+    J.attributeObject("functions", [&] {
+      std::array<unsigned, outcomes> functions = count_functions();
+      for (unsigned outcome = 0; outcome < outcomes; ++outcome)
+        J.attribute(kOutcomes[outcome], functions[outcome]);
+    });
+    J.attributeObject("phases", [&] {
+      for (unsigned phase = 0; phase < phases; ++phase)
+        J.attributeObject(kPhases[phase], [&] {
+          J.attribute("wall", times[phase].wall);
+          J.attribute("cpu", times[phase].cpu);
+        });
+    });
+    J.attributeArray("units", [&] {
+      for (const unit &unit : units_)
+        J.object([&] {
+          J.attribute("path", unit.path);
+          J.attribute("wall", unit.wall());
+          J.attribute("cpu", unit.total().cpu);
+          J.attribute("files", unit.files);
+          J.attribute("declarations", unit.declarations);
+          J.attribute("findings", unit.findings);
+          J.attribute("ast_memory", static_cast<int64_t>(unit.ast_memory));
+          J.attribute("peak_memory",
+                      static_cast<int64_t>(unit.peak_memory));
+        });
+    });
+  });
+  OS << "\n";
+}
+
+std::optional<finding> get_finding(const clang::DiagnosticIDs &IDs,
+                                   unsigned id) {
+  llvm::StringRef description = IDs.getDescription(id);
+  for (unsigned index = 0; index < std::size(kFindings); ++index)
+    if (description == kFindings[index].message)
+      return static_cast<finding>(index);
+  return std::nullopt;
+}
+}
@@ -0,0 +1,1357 @@
+// Copyright (c) 2021 Saleem Abdulrasool.  All Rights Reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef IDT_SCANNER_HH
+#define IDT_SCANNER_HH
+
+#include "clang/AST/Mangle.h"
+#include "clang/AST/RecursiveASTVisitor.h"
+#include "clang/Basic/Diagnostic.h"
+#include "clang/Basic/FileManager.h"
+#include "clang/Index/USRGeneration.h"
+#include "clang/Lex/Lexer.h"
+
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/TimeProfiler.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <array>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace idt {
+extern llvm::cl::OptionCategory category;
+
+extern llvm::cl::opt<std::string> export_macro;
+extern llvm::cl::list<std::string> clients;
+extern llvm::cl::opt<bool> extern_templates;
+extern llvm::cl::opt<bool> inline_data_access;
+extern llvm::cl::opt<bool> internal_linkage;
+
+template <typename Key, typename Compare, typename Allocator>
+bool contains(const std::set<Key, Compare, Allocator>& set, const Key& key) {
+  return set.find(key) != set.end();
+}
+
+const std::set<std::string> &get_ignored_functions();
+
+std::string get_normalized_path(llvm::StringRef path);
+
+// Paths seen by a translation unit are relative to the working directory of
+// its file system, which is not the one of the process with multiple workers.
+std::string get_normalized_path(const clang::FileManager &file_manager,
+                                llvm::StringRef path);
+
+// Resolves the clients and library directories named on the command line
+// against the directory idt was invoked from.  A single worker runs in the
+// directory of each compile command, so they must be resolved before any
+// translation unit is processed.
+void resolve_inputs();
+
+// Returns whether the translation unit at the absolute `path` is a client.
+bool is_client(llvm::StringRef path);
+
+// Returns the library which the header at `path` belongs to.  Without any
+// explicit libraries, every header belongs to the library identified by the
+// export macro.
+std::optional<std::string> get_library(llvm::StringRef path);
+
+// Returns whether `name` identifies a library which headers may belong to.
+bool is_library(llvm::StringRef name);
+
+// The symbols which a binary exports.  Weak definitions are the instances of
+// symbols with vague linkage (e.g. inline functions and implicit members)
+// which the binary happened to emit.
+struct export_table {
+  std::set<std::string> symbols;
+  std::set<std::string> weak;
+};
+
+// Reads the export table of the binary at `path`: a shared library, an
+// object file, an archive or an import library.
+llvm::Expected<export_table> read_exports(llvm::StringRef path);
+
+enum class kind : unsigned { function, variable, record };
+enum class exposure : unsigned {
+  exported,
+  unexported_public,
+  exported_private,
+};
+
+// The declarations observed across all translation units, keyed by USR so
+// that headers included into multiple translation units are counted once.
+class inventory {
+public:
+  struct entry {
+    std::string path;
+    std::string library;
+    idt::kind kind;
+    idt::exposure exposure;
+    std::string name;
+    unsigned line;
+    std::vector<std::string> symbols;
+    bool inline_function = false;
+    // A member of a class whose class-level export is suggested, which is
+    // exported with the class rather than on its own.
+    bool class_member = false;
+    std::string signature;
+    std::string attributes;
+  };
+
+  // An implicit instantiation of a template from a header, and where to
+  // declare it as an extern template.
+  struct instantiation {
+    std::string declaration;
+    // The class-key of a class, which the export macro must follow.
+    std::string key;
+    std::string path;
+    unsigned line = 0;
+    unsigned column = 0;
+    unsigned units = 0;
+  };
+
+  // An inline function from a header which accesses imported variables, and
+  // the number of translation units which use it.
+  struct data_access {
+    std::string name;
+    std::string path;
+    unsigned line = 0;
+    std::vector<std::string> variables;
+    unsigned units = 0;
+  };
+
+  // A declaration from a header of an external function or variable, and the
+  // translation units which define and use it.
+  struct linkage {
+    std::string name;
+    std::string path;
+    unsigned line = 0;
+    bool exported = false;
+    llvm::SmallVector<unsigned, 1> definitions;
+    llvm::SmallVector<unsigned, 4> uses;
+  };
+
+private:
+  // Serializes the workers.  The time spent in the inventory, including
+  // waiting for other workers, is traced as an inventory lookup.
+  class guard {
+    llvm::TimeTraceScope scope_;
+    std::lock_guard<std::mutex> lock_;
+
+  public:
+    explicit guard(std::mutex &mutex)
+        : scope_("Inventory lookup"), lock_(mutex) {}
+  };
+
+  const bool collect_;
+  mutable std::mutex mutex_;
+  std::vector<std::string> units_;
+  llvm::StringMap<entry> entries_;
+  llvm::StringMap<unsigned> references_;
+  unsigned clients_ = 0;
+  llvm::StringMap<linkage> linkages_;
+  llvm::StringMap<instantiation> instantiations_;
+  llvm::StringMap<data_access> data_accesses_;
+  std::set<std::string> implicit_;
+
+public:
+  // The declarations are only collected when `collect` is set, as only the
+  // reports of the export surface read them.
+  explicit inventory(bool collect) : collect_(collect) {}
+
+  bool collecting() const { return collect_; }
+
+  bool contains(llvm::StringRef usr) const {
+    guard lock{mutex_};
+    return entries_.find(usr) != entries_.end();
+  }
+
+  void insert(llvm::StringRef usr, entry &&value) {
+    guard lock{mutex_};
+    entries_.try_emplace(usr, std::move(value));
+  }
+
+  // Note the symbols of the implicit members of a class, which a binary may
+  // export although no declaration accounts for them.
+  void add_implicit(std::vector<std::string> &&symbols) {
+    guard lock{mutex_};
+    implicit_.insert(std::make_move_iterator(symbols.begin()),
+                     std::make_move_iterator(symbols.end()));
+  }
+
+  void add_client() {
+    guard lock{mutex_};
+    ++clients_;
+  }
+
+  unsigned add_unit(std::string path) {
+    guard lock{mutex_};
+    units_.push_back(std::move(path));
+    return units_.size() - 1;
+  }
+
+  // Note that `unit` defines and/or uses the declaration `usr`; `declaration`
+  // describes the declaration when it is first seen.
+  template <typename Declaration_>
+  void link(llvm::StringRef usr, unsigned unit, bool defined, bool used,
+            Declaration_ &&declaration) {
+    guard lock{mutex_};
+    auto result = linkages_.try_emplace(usr);
+    linkage &value = result.first->getValue();
+    if (result.second)
+      declaration(value);
+    if (defined)
+      value.definitions.push_back(unit);
+    if (used)
+      value.uses.push_back(unit);
+  }
+
+  void reference(llvm::StringRef usr) {
+    guard lock{mutex_};
+    ++references_[usr];
+  }
+
+  bool contains_data_access(llvm::StringRef usr) const {
+    guard lock{mutex_};
+    return data_accesses_.find(usr) != data_accesses_.end();
+  }
+
+  void access(llvm::StringRef usr, data_access &&value) {
+    guard lock{mutex_};
+    data_accesses_.try_emplace(usr, std::move(value));
+  }
+
+  void use_data_access(llvm::StringRef usr) {
+    guard lock{mutex_};
+    auto access = data_accesses_.find(usr);
+    if (access != data_accesses_.end())
+      ++access->getValue().units;
+  }
+
+  void instantiate(const instantiation &value) {
+    guard lock{mutex_};
+    auto result = instantiations_.try_emplace(value.declaration, value);
+    ++result.first->getValue().units;
+  }
+
+  void report(llvm::raw_ostream &OS) const;
+
+  // Returns false if any library exports more symbols than its budget.
+  bool check(const std::map<std::string, unsigned> &budgets,
+             llvm::raw_ostream &OS) const;
+
+  // Joins the export table of a binary against the declarations, reporting
+  // symbols which no declaration accounts for and exported declarations
+  // which the binary does not provide.
+  void cross_check(llvm::StringRef binary, const export_table &exports,
+                   llvm::raw_ostream &OS) const;
+
+  // The symbols of the audited interface of `library` (or of every library),
+  // sorted by name: the public declarations which are, or should be,
+  // exported.  Exported private and inline functions are excluded.
+  std::vector<std::pair<std::string, idt::kind>>
+  interface(llvm::StringRef library) const;
+
+  // Recommends extern template declarations, and the exported explicit
+  // instantiations backing them, for the templates which the most
+  // translation units instantiate.  The declarations are suggested as
+  // parseable fix-its inserted after the template definition and the
+  // declarations which the template arguments name.
+  void report_instantiations(llvm::raw_ostream &OS) const;
+
+  // Reports the inline functions which access imported variables, most used
+  // first.  Each access is an indirection through the import address table
+  // in every client which inlines the function.
+  void report_data_accesses(llvm::raw_ostream &OS) const;
+
+  // Reports the unexported header declarations which are only used by the
+  // translation unit defining them; these do not need external linkage.
+  void report_linkage(llvm::raw_ostream &OS) const;
+
+  // Writes the exported surface, one declaration per line, sorted by USR so
+  // that two snapshots can be compared in a single pass.  The fields are
+  // separated by tabs: USR, kind, qualified name, signature, attributes.
+  void write_snapshot(llvm::raw_ostream &OS) const;
+
+  // Reports the exports which none of the clients reference; these are
+  // candidates to stop exporting.
+  void report_unused(llvm::raw_ostream &OS) const;
+};
+
+// The peak resident set size of the process, in bytes.
+size_t get_peak_memory();
+
+// The CPU time of the calling thread, in seconds.  Concurrent workers each
+// run on their own thread, so the CPU time of the process would account the
+// time of every worker to each of them.
+double get_thread_cpu_time();
+
+// The time spent on, and the work done for, each translation unit.
+class statistics {
+public:
+  // Clang preprocesses lazily as it parses, so preprocessing is accounted to
+  // the parse phase along with semantic analysis.
+  enum phase : unsigned { setup, parse, traverse, fixits, phases };
+
+  // Where `VisitFunctionDecl` finished with a function declaration.
+  enum outcome : unsigned {
+    client,
+    system_header,
+    dependent,
+    has_body,
+    friend_declaration,
+    deleted_or_defaulted,
+    private_member,
+    pure_virtual,
+    annotated,
+    ignored,
+    class_export,
+    reported,
+    outcomes
+  };
+
+  // The wall time, and the CPU time of the worker thread, of a phase.
+  struct duration {
+    double wall = 0;
+    double cpu = 0;
+
+    duration &operator+=(const duration &other) {
+      wall += other.wall;
+      cpu += other.cpu;
+      return *this;
+    }
+  };
+
+  struct unit {
+    std::string path;
+    std::array<duration, phases> times{};
+    unsigned files = 0;
+    unsigned declarations = 0;
+    unsigned findings = 0;
+    // The memory allocated for the AST, and the peak resident set size of
+    // the process once the translation unit was traversed.
+    size_t ast_memory = 0;
+    size_t peak_memory = 0;
+    std::array<unsigned, outcomes> functions{};
+    // The inventory lookups for declarations, and those which found the
+    // declaration already recorded by another translation unit.
+    unsigned lookups = 0;
+    unsigned hits = 0;
+    std::chrono::steady_clock::time_point wall_mark;
+    double cpu_mark = 0;
+
+    // Starts timing the first phase.  The phases of a translation unit are
+    // timed on the thread of the worker which processes it.
+    void start() {
+      wall_mark = std::chrono::steady_clock::now();
+      cpu_mark = get_thread_cpu_time();
+    }
+
+    // Accounts the time since the end of the previous phase to `phase`.
+    void lap(statistics::phase phase) {
+      auto wall = std::chrono::steady_clock::now();
+      double cpu = get_thread_cpu_time();
+      times[phase].wall +=
+          std::chrono::duration<double>(wall - wall_mark).count();
+      times[phase].cpu += cpu - cpu_mark;
+      wall_mark = wall;
+      cpu_mark = cpu;
+    }
+
+    duration total() const {
+      duration total;
+      for (const auto &time : times)
+        total += time;
+      return total;
+    }
+
+    double wall() const { return total().wall; }
+  };
+
+private:
+  static constexpr const char *kOutcomes[] = {
+    "client", "system header", "dependent", "has body", "friend",
+    "deleted/defaulted", "private", "pure", "annotated", "ignored",
+    "class export", "reported",
+  };
+
+  std::mutex mutex_;
+  std::vector<unit> units_;
+
+public:
+  void add(unit unit) {
+    std::lock_guard<std::mutex> lock{mutex_};
+    units_.push_back(std::move(unit));
+  }
+
+  void print(llvm::raw_ostream &OS) const;
+
+  // Writes the statistics as JSON, for tracking over time.
+  void write(llvm::raw_ostream &OS) const;
+
+private:
+  std::array<unsigned, outcomes> count_functions() const {
+    std::array<unsigned, outcomes> functions{};
+    for (const unit &unit : units_)
+      for (unsigned outcome = 0; outcome < outcomes; ++outcome)
+        functions[outcome] += unit.functions[outcome];
+    return functions;
+  }
+
+  static double mebibytes(size_t bytes) {
+    return static_cast<double>(bytes) / (1024 * 1024);
+  }
+};
+
+// Collects the imported (or exported) variables which a function body
+// accesses.
+class data_access_visitor
+    : public clang::RecursiveASTVisitor<data_access_visitor> {
+  void access(const clang::ValueDecl *D) {
+    const auto *VD = llvm::dyn_cast<clang::VarDecl>(D);
+    if (!VD)
+      return;
+    if (!VD->hasAttr<clang::DLLImportAttr>() &&
+        !VD->hasAttr<clang::DLLExportAttr>())
+      return;
+    if (!llvm::is_contained(variables, VD))
+      variables.push_back(VD);
+  }
+
+public:
+  llvm::SmallVector<const clang::VarDecl *, 4> variables;
+
+  bool VisitDeclRefExpr(clang::DeclRefExpr *DRE) {
+    access(DRE->getDecl());
+    return true;
+  }
+
+  bool VisitMemberExpr(clang::MemberExpr *ME) {
+    access(ME->getMemberDecl());
+    return true;
+  }
+};
+
+// The findings which the visitor reports.
+enum class finding : unsigned {
+  unexported_public_interface,
+  exported_private_interface,
+  exported_inline_interface,
+  unexported_polymorphic_class,
+  polymorphic_class_without_key_function,
+  member_level_interface,
+};
+
+// The name of each finding for machine-readable output, and the remark which
+// reports it.
+struct finding_description {
+  const char *name;
+  const char *message;
+};
+
+inline constexpr finding_description kFindings[] = {
+  { "unexported-public-interface", "unexported public interface %0" },
+  { "exported-private-interface", "exported private interface %0" },
+  { "exported-inline-interface", "exported inline interface %0" },
+  { "unexported-polymorphic-class",
+    "unexported polymorphic class %0 requires class-level export for its "
+    "vtable and type information" },
+  { "polymorphic-class-without-key-function",
+    "polymorphic class %0 has no key function; its vtable is emitted in every "
+    "client" },
+  { "member-level-interface",
+    "non-polymorphic class %0 only requires member-level export" },
+};
+
+// The finding which the diagnostic `id` reports, if it is one.
+std::optional<finding> get_finding(const clang::DiagnosticIDs &IDs,
+                                   unsigned id);
+
+// A finding which the visitor records in place of reporting a remark.
+struct recorded_finding {
+  idt::finding finding;
+  clang::SourceLocation location;
+  const clang::NamedDecl *declaration;
+  llvm::SmallVector<clang::FixItHint, 1> fixits;
+};
+
+class visitor : public clang::RecursiveASTVisitor<visitor> {
+  clang::ASTContext &context_;
+  clang::SourceManager &source_manager_;
+  clang::ASTNameGenerator mangler_;
+  std::unique_ptr<clang::MangleContext> mangle_context_;
+  idt::inventory &inventory_;
+  bool client_;
+  unsigned unit_;
+  llvm::DenseSet<const clang::Decl *> referenced_;
+  llvm::DenseSet<const clang::Decl *> linked_;
+  unsigned declarations_ = 0;
+  unsigned findings_ = 0;
+  std::array<unsigned, idt::statistics::outcomes> functions_{};
+  unsigned lookups_ = 0;
+  unsigned hits_ = 0;
+  bool record_;
+  std::vector<idt::recorded_finding> recorded_;
+  std::array<unsigned, std::size(kFindings)> ids_{};
+
+  // Counts where `VisitFunctionDecl` finished with a function.  The visitor
+  // belongs to a single worker, so the counts need no synchronization.
+  bool finish(idt::statistics::outcome outcome) {
+    ++functions_[outcome];
+    return true;
+  }
+
+  // Reports `finding` for `ND` as a remark.  When the findings are recorded
+  // instead, the diagnostics engine is bypassed entirely, and the finding is
+  // only resolved to its location and name if the output requires it.
+  void report(idt::finding finding, clang::SourceLocation location,
+              const clang::NamedDecl *ND,
+              llvm::ArrayRef<clang::FixItHint> fixits = {}) {
+    ++findings_;
+
+    if (record_) {
+      recorded_.push_back({finding, location, ND, {}});
+      recorded_.back().fixits.append(fixits.begin(), fixits.end());
+      return;
+    }
+
+    clang::DiagnosticsEngine &diagnostics_engine = context_.getDiagnostics();
+
+    unsigned &kID = ids_[static_cast<unsigned>(finding)];
+    if (!kID)
+      kID = diagnostics_engine.getDiagnosticIDs()->getCustomDiagID(
+          clang::DiagnosticIDs::Remark,
+          kFindings[static_cast<unsigned>(finding)].message);
+
+    clang::DiagnosticBuilder diagnostic =
+        diagnostics_engine.Report(location, kID);
+    diagnostic << ND;
+    for (const auto &fixit : fixits)
+      diagnostic << fixit;
+  }
+
+  template <typename Decl_>
+  inline clang::FullSourceLoc get_location(const Decl_ *TD) const {
+    return context_.getFullLoc(TD->getBeginLoc()).getExpansionLoc();
+  }
+
+  std::string get_path(clang::FullSourceLoc location) const {
+    llvm::SmallString<256> path;
+    if (const clang::FileEntry *FE = location.getFileEntry())
+      path = FE->tryGetRealPathName();
+    if (path.empty())
+      path = source_manager_.getFilename(location);
+    return get_normalized_path(source_manager_.getFileManager(), path);
+  }
+
+  // The location following the declaration `D` and its semicolon, if any.
+  clang::SourceLocation get_end(const clang::Decl *D) const {
+    clang::SourceLocation location =
+        source_manager_.getExpansionLoc(D->getEndLoc());
+    clang::SourceLocation end = clang::Lexer::findLocationAfterToken(
+        location, clang::tok::semi, source_manager_, context_.getLangOpts(),
+        /*SkipTrailingWhitespaceAndNewLine=*/false);
+    if (end.isInvalid())
+      end = clang::Lexer::getLocForEndOfToken(location, 0, source_manager_,
+                                              context_.getLangOpts());
+    return end;
+  }
+
+  // Moves `point` past the declaration `D`, which an extern template
+  // declaration at `point` names.  Returns false if `D` cannot be named at
+  // `point`: it is declared neither in the same file nor in a file which that
+  // file includes.
+  bool anchor(const clang::Decl *D, clang::SourceLocation &point) const {
+    clang::SourceLocation location =
+        source_manager_.getExpansionLoc(D->getLocation());
+    // Builtin declarations can be named anywhere.
+    if (location.isInvalid())
+      return true;
+
+    clang::FileID header = source_manager_.getFileID(point);
+    clang::FileID file = source_manager_.getFileID(location);
+    if (file != header) {
+      while (file.isValid() && file != header)
+        file = source_manager_.getFileID(source_manager_.getIncludeLoc(file));
+      return file == header;
+    }
+
+    clang::SourceLocation end = get_end(D);
+    if (end.isInvalid())
+      return false;
+    if (source_manager_.isBeforeInTranslationUnit(point, end))
+      point = end;
+    return true;
+  }
+
+  bool anchor(clang::QualType type, clang::SourceLocation &point) const {
+    type = type.getCanonicalType();
+    if (const auto *MPT = type->getAs<clang::MemberPointerType>())
+      return anchor(clang::QualType(MPT->getClass(), 0), point) &&
+             anchor(MPT->getPointeeType(), point);
+    if (!type->getPointeeType().isNull())
+      return anchor(type->getPointeeType(), point);
+    if (const clang::ArrayType *AT = context_.getAsArrayType(type))
+      return anchor(AT->getElementType(), point);
+    if (const auto *FPT = type->getAs<clang::FunctionProtoType>())
+      return anchor(FPT->getReturnType(), point) &&
+             llvm::all_of(FPT->getParamTypes(), [&](clang::QualType parameter) {
+               return anchor(parameter, point);
+             });
+
+    const clang::TagDecl *TD = type->getAsTagDecl();
+    if (!TD)
+      return true;
+    if (const auto *CTSD =
+            llvm::dyn_cast<clang::ClassTemplateSpecializationDecl>(TD))
+      return anchor(CTSD->getSpecializedTemplate(), point) &&
+             anchor(CTSD->getTemplateArgs().asArray(), point);
+    if (const clang::TagDecl *definition = TD->getDefinition())
+      TD = definition;
+    return anchor(static_cast<const clang::Decl *>(TD), point);
+  }
+
+  bool anchor(llvm::ArrayRef<clang::TemplateArgument> arguments,
+              clang::SourceLocation &point) const {
+    for (const clang::TemplateArgument &argument : arguments) {
+      switch (argument.getKind()) {
+      case clang::TemplateArgument::Type:
+        if (!anchor(argument.getAsType(), point))
+          return false;
+        break;
+      case clang::TemplateArgument::Declaration:
+        if (!anchor(argument.getAsDecl(), point))
+          return false;
+        break;
+      case clang::TemplateArgument::Integral:
+        if (!anchor(argument.getIntegralType(), point))
+          return false;
+        break;
+      case clang::TemplateArgument::Template:
+      case clang::TemplateArgument::TemplateExpansion:
+        if (const clang::TemplateDecl *TD =
+                argument.getAsTemplateOrTemplatePattern().getAsTemplateDecl())
+          if (!anchor(TD, point))
+            return false;
+        break;
+      case clang::TemplateArgument::Pack:
+        if (!anchor(argument.pack_elements(), point))
+          return false;
+        break;
+      default:
+        break;
+      }
+    }
+    return true;
+  }
+
+  static llvm::ArrayRef<clang::TemplateArgument>
+  get_template_arguments(const clang::ClassTemplateSpecializationDecl *CTSD) {
+    return CTSD->getTemplateArgs().asArray();
+  }
+
+  static llvm::ArrayRef<clang::TemplateArgument>
+  get_template_arguments(const clang::FunctionDecl *FD) {
+    if (const clang::TemplateArgumentList *arguments =
+            FD->getTemplateSpecializationArgs())
+      return arguments->asArray();
+    return {};
+  }
+
+  // Count the implicit instantiations of a template in this translation unit.
+  // `end` is the location following the template definition.  An extern
+  // template declaration is inserted there, or after the last declaration
+  // which its template arguments name, if they can be named there.
+  template <typename Specialization_, typename Declaration_>
+  void instantiations(llvm::iterator_range<Specialization_> specializations,
+                      clang::SourceLocation end, Declaration_ &&declaration) {
+    for (const auto *specialization : specializations) {
+      if (specialization->getTemplateSpecializationKind() !=
+          clang::TSK_ImplicitInstantiation)
+        continue;
+
+      idt::inventory::instantiation instantiation;
+      if (!declaration(specialization, instantiation))
+        continue;
+
+      clang::SourceLocation point = end;
+      if (point.isValid() && point.isFileID() &&
+          anchor(get_template_arguments(specialization), point)) {
+        clang::FullSourceLoc location{point, source_manager_};
+        instantiation.path = get_path(location);
+        instantiation.line = location.getLineNumber();
+        instantiation.column = location.getColumnNumber();
+      }
+      inventory_.instantiate(instantiation);
+    }
+  }
+
+  // The vtable and type information symbols of a polymorphic class.
+  std::vector<std::string>
+  get_class_symbols(const clang::CXXRecordDecl *RD) const {
+    std::vector<std::string> symbols;
+    if (!RD->isDynamicClass())
+      return symbols;
+
+    auto mangle = [&symbols](auto &&mangler) {
+      std::string symbol;
+      llvm::raw_string_ostream OS{symbol};
+      mangler(OS);
+      symbols.push_back(OS.str());
+    };
+
+    clang::QualType type = context_.getRecordType(RD);
+    if (auto *MC =
+            llvm::dyn_cast<clang::ItaniumMangleContext>(mangle_context_.get())) {
+      mangle([&](llvm::raw_ostream &OS) { MC->mangleCXXVTable(RD, OS); });
+      mangle([&](llvm::raw_ostream &OS) { MC->mangleCXXRTTI(type, OS); });
+      mangle([&](llvm::raw_ostream &OS) { MC->mangleCXXRTTIName(type, OS); });
+    } else if (auto *MC = llvm::dyn_cast<clang::MicrosoftMangleContext>(
+                   mangle_context_.get())) {
+      mangle([&](llvm::raw_ostream &OS) { MC->mangleCXXVFTable(RD, {}, OS); });
+    }
+    return symbols;
+  }
+
+  // The symbols of the implicit members of a class, which are defined in
+  // every translation unit which uses them.
+  std::vector<std::string>
+  get_implicit_symbols(const clang::CXXRecordDecl *RD) {
+    std::vector<std::string> symbols;
+    for (const clang::CXXMethodDecl *MD : RD->methods()) {
+      if (!MD->isImplicit() || MD->isDeleted())
+        continue;
+      std::vector<std::string> manglings = mangler_.getAllManglings(MD);
+      symbols.insert(symbols.end(), std::make_move_iterator(manglings.begin()),
+                     std::make_move_iterator(manglings.end()));
+    }
+    return symbols;
+  }
+
+  // The type of a declaration as it appears in a snapshot: the function or
+  // variable type, or the tag and bases of a class.
+  std::string get_signature(const clang::NamedDecl *ND) const {
+    const clang::PrintingPolicy &policy = context_.getPrintingPolicy();
+    if (const auto *VD = llvm::dyn_cast<clang::ValueDecl>(ND))
+      return VD->getType().getAsString(policy);
+
+    std::string signature;
+    if (const auto *RD = llvm::dyn_cast<clang::CXXRecordDecl>(ND)) {
+      signature = RD->getKindName().str();
+      if (RD->hasDefinition() && RD->getNumBases()) {
+        llvm::raw_string_ostream OS{signature};
+        OS << " : ";
+        llvm::interleaveComma(RD->bases(), OS,
+                              [&](const clang::CXXBaseSpecifier &base) {
+                                if (base.isVirtual())
+                                  OS << "virtual ";
+                                OS << base.getType().getAsString(policy);
+                              });
+      }
+    }
+    return signature;
+  }
+
+  // The properties of a declaration which affect its ABI, beyond its type.
+  std::string get_attributes(const clang::NamedDecl *ND) const {
+    llvm::SmallVector<llvm::StringRef, 4> attributes;
+    if (ND->hasAttr<clang::DLLExportAttr>())
+      attributes.push_back("dllexport");
+    if (ND->hasAttr<clang::DLLImportAttr>())
+      attributes.push_back("dllimport");
+    if (ND->getAccess() == clang::AS_protected)
+      attributes.push_back("protected");
+    else if (ND->getAccess() == clang::AS_private)
+      attributes.push_back("private");
+
+    if (const auto *FD = llvm::dyn_cast<clang::FunctionDecl>(ND)) {
+      if (FD->isInlined())
+        attributes.push_back("inline");
+      if (FD->isConstexpr())
+        attributes.push_back("constexpr");
+      if (const auto *MD = llvm::dyn_cast<clang::CXXMethodDecl>(FD)) {
+        if (MD->isStatic())
+          attributes.push_back("static");
+        if (MD->isVirtual())
+          attributes.push_back("virtual");
+      }
+    } else if (const auto *VD = llvm::dyn_cast<clang::VarDecl>(ND)) {
+      if (VD->isStaticDataMember())
+        attributes.push_back("static");
+      if (VD->isInline())
+        attributes.push_back("inline");
+    } else if (const auto *RD = llvm::dyn_cast<clang::CXXRecordDecl>(ND)) {
+      if (RD->hasDefinition() && RD->isPolymorphic())
+        attributes.push_back("polymorphic");
+    }
+    return llvm::join(attributes, ",");
+  }
+
+  // Attribute the declaration to the export surface of its header.
+  void record(const clang::NamedDecl *ND, clang::FullSourceLoc location,
+              idt::kind kind, idt::exposure exposure,
+              bool inline_function = false) {
+    if (!inventory_.collecting())
+      return;
+
+    llvm::SmallString<128> usr;
+    if (clang::index::generateUSRForDecl(ND, usr))
+      return;
+    ++lookups_;
+    if (inventory_.contains(usr)) {
+      ++hits_;
+      return;
+    }
+
+    std::string path = get_path(location);
+    std::optional<std::string> library = get_library(path);
+    if (!library)
+      return;
+
+    idt::inventory::entry entry{std::move(path), std::move(*library), kind,
+                                exposure};
+    entry.name = ND->getQualifiedNameAsString();
+    entry.line = location.getExpansionLineNumber();
+    if (llvm::isa<clang::CXXMethodDecl>(ND))
+      entry.symbols = mangler_.getAllManglings(ND);
+    else if (llvm::isa<clang::FunctionDecl, clang::VarDecl>(ND))
+      entry.symbols.push_back(mangler_.getName(ND));
+    else if (const auto *RD = llvm::dyn_cast<clang::CXXRecordDecl>(ND)) {
+      entry.symbols = get_class_symbols(RD);
+      inventory_.add_implicit(get_implicit_symbols(RD));
+    }
+    entry.inline_function = inline_function;
+    if (exposure == idt::exposure::unexported_public &&
+        llvm::isa<clang::CXXMethodDecl, clang::VarDecl>(ND))
+      if (const auto *RD =
+              llvm::dyn_cast<clang::CXXRecordDecl>(ND->getDeclContext()))
+        entry.class_member = suggests_class_export(RD);
+    entry.signature = get_signature(ND);
+    entry.attributes = get_attributes(ND);
+    inventory_.insert(usr, std::move(entry));
+  }
+
+  // Note a reference from a client to a declaration of the library.  The
+  // declaration must be odr-used, so that the client requires the symbol.
+  void reference(const clang::NamedDecl *ND, clang::FullSourceLoc location) {
+    if (source_manager_.isInSystemHeader(location))
+      return;
+    if (!ND->isUsed() || !referenced_.insert(ND->getCanonicalDecl()).second)
+      return;
+
+    llvm::SmallString<128> usr;
+    if (!clang::index::generateUSRForDecl(ND, usr))
+      inventory_.reference(usr);
+  }
+
+  // Note the inline function definitions which access imported variables,
+  // and count the translation units which use them.
+  void data_accesses(const clang::FunctionDecl *FD,
+                     clang::FullSourceLoc location) {
+    if (source_manager_.isInSystemHeader(location) ||
+        FD->isDependentContext())
+      return;
+
+    llvm::SmallString<128> usr;
+    if (clang::index::generateUSRForDecl(FD, usr))
+      return;
+
+    if (!inventory_.contains_data_access(usr)) {
+      data_access_visitor finder;
+      finder.TraverseStmt(FD->getBody());
+      if (finder.variables.empty())
+        return;
+
+      idt::inventory::data_access access;
+      access.name = FD->getQualifiedNameAsString();
+      access.path = get_path(location);
+      access.line = location.getExpansionLineNumber();
+      for (const clang::VarDecl *VD : finder.variables)
+        access.variables.push_back(VD->getQualifiedNameAsString());
+      inventory_.access(usr, std::move(access));
+    }
+
+    if (FD->isUsed())
+      inventory_.use_data_access(usr);
+  }
+
+  // Note whether this translation unit defines or uses an external function
+  // or variable which a header declares.
+  template <typename Decl_>
+  void linkage(const Decl_ *D) {
+    if (!linked_.insert(D->getCanonicalDecl()).second)
+      return;
+    if (!D->isExternallyVisible())
+      return;
+
+    const Decl_ *declaration = nullptr;
+    for (const Decl_ *redeclaration : D->redecls()) {
+      clang::FullSourceLoc location = get_location(redeclaration);
+      if (source_manager_.isInSystemHeader(location))
+        return;
+      if (!declaration && !source_manager_.isInMainFile(location))
+        declaration = redeclaration;
+    }
+    if (!declaration)
+      return;
+
+    const Decl_ *definition = D->getDefinition();
+    bool defined = definition &&
+                   source_manager_.isInMainFile(get_location(definition));
+    bool used = D->isUsed();
+    if (!defined && !used)
+      return;
+
+    llvm::SmallString<128> usr;
+    if (clang::index::generateUSRForDecl(D, usr))
+      return;
+
+    inventory_.link(usr, unit_, defined, used,
+                    [&](idt::inventory::linkage &linkage) {
+                      clang::FullSourceLoc location = get_location(declaration);
+                      linkage.name = D->getQualifiedNameAsString();
+                      linkage.path = get_path(location);
+                      linkage.line = location.getExpansionLineNumber();
+                      linkage.exported =
+                          D->template hasAttr<clang::DLLExportAttr>() ||
+                          D->template hasAttr<clang::DLLImportAttr>();
+                    });
+  }
+
+public:
+  explicit visitor(clang::ASTContext &context, idt::inventory &inventory,
+                   bool client, unsigned unit, bool record = false)
+      : context_(context), source_manager_(context.getSourceManager()),
+        mangler_(context), mangle_context_(context.createMangleContext()),
+        inventory_(inventory), client_(client), unit_(unit), record_(record) {}
+
+  unsigned declarations() const { return declarations_; }
+  unsigned findings() const { return findings_; }
+  const std::array<unsigned, idt::statistics::outcomes> &functions() const {
+    return functions_;
+  }
+  unsigned lookups() const { return lookups_; }
+  unsigned hits() const { return hits_; }
+  llvm::ArrayRef<idt::recorded_finding> recorded() const { return recorded_; }
+
+  bool VisitDecl(clang::Decl *D) {
+    ++declarations_;
+    return true;
+  }
+
+  bool VisitFunctionDecl(clang::FunctionDecl *FD) {
+    clang::FullSourceLoc location = get_location(FD);
+
+    if (inline_data_access && FD->doesThisDeclarationHaveABody() &&
+        FD->isInlined())
+      data_accesses(FD, location);
+
+    // Only free functions can be given internal linkage.
+    if (internal_linkage && !llvm::isa<clang::CXXMethodDecl>(FD) &&
+        !FD->isInlined() && !FD->isMain() && !FD->isDeleted() &&
+        FD->getTemplatedKind() == clang::FunctionDecl::TK_NonTemplate &&
+        !FD->isDependentContext())
+      linkage(FD);
+
+    // Clients only contribute references to the library.
+    if (client_) {
+      reference(FD, location);
+      return finish(idt::statistics::client);
+    }
+
+    // Ignore declarations from the system.
+    if (source_manager_.isInSystemHeader(location))
+      return finish(idt::statistics::system_header);
+
+    // We are only interested in non-dependent types.
+    if (FD->isDependentContext())
+      return finish(idt::statistics::dependent);
+
+    // If the function has a body, it can be materialized by the user.
+    if (FD->hasBody()) {
+      // Exporting an inline function forces an out-of-line definition and an
+      // entry in the export table, which the user does not need.
+      if (FD->isThisDeclarationADefinition() && FD->isInlined() &&
+          !FD->isImplicit() && !FD->isDeleted()) {
+        const clang::Attr *A = FD->getAttr<clang::DLLExportAttr>();
+        if (!A)
+          A = FD->getAttr<clang::DLLImportAttr>();
+        if (A)
+          exported_inline(FD, A, location);
+      }
+      return finish(idt::statistics::has_body);
+    }
+
+    // Ignore friend declarations.
+    if (llvm::isa<clang::FriendDecl>(FD))
+      return finish(idt::statistics::friend_declaration);
+
+    // Ignore deleted and defaulted functions (e.g. operators).
+    if (FD->isDeleted() || FD->isDefaulted())
+      return finish(idt::statistics::deleted_or_defaulted);
+
+    if (const auto *MD = llvm::dyn_cast<clang::CXXMethodDecl>(FD)) {
+      // Ignore private members (except for a negative check).
+      if (MD->getAccess() == clang::AccessSpecifier::AS_private) {
+        // TODO(compnerd) this should also handle `__visibility__`
+        if (MD->hasAttr<clang::DLLExportAttr>()) {
+          // TODO(compnerd) this should emit a fix-it to remove the attribute
+          report(finding::exported_private_interface, location, MD);
+          record(MD, location, kind::function, exposure::exported_private);
+        }
+        return finish(idt::statistics::private_member);
+      }
+
+      // Pure virtual methods cannot be exported.
+      if (MD->isPure())
+        return finish(idt::statistics::pure_virtual);
+    }
+
+    // If the function has a dll-interface, it is properly annotated.
+    // TODO(compnerd) this should also handle `__visibility__`
+    if (FD->hasAttr<clang::DLLExportAttr>() ||
+        FD->hasAttr<clang::DLLImportAttr>()) {
+      record(FD, location, kind::function, exposure::exported);
+      return finish(idt::statistics::annotated);
+    }
+
+    // Ignore known forward declarations (builtins)
+    // TODO(compnerd) replace with std::set::contains in C++20
+    if (contains(get_ignored_functions(), FD->getNameAsString()))
+      return finish(idt::statistics::ignored);
+
+    // The members of a class which is to be exported as a whole are exported
+    // with it, and cannot also be exported individually.
+    if (const auto *MD = llvm::dyn_cast<clang::CXXMethodDecl>(FD)) {
+      if (suggests_class_export(MD->getParent())) {
+        record(FD, location, kind::function, exposure::unexported_public);
+        return finish(idt::statistics::class_export);
+      }
+    }
+
+    clang::SourceLocation insertion_point =
+        FD->getTemplatedKind() == clang::FunctionDecl::TK_NonTemplate
+            ? FD->getBeginLoc()
+            : FD->getInnerLocStart();
+    report(finding::unexported_public_interface, location, FD,
+           clang::FixItHint::CreateInsertion(insertion_point,
+                                             export_macro + " "));
+    record(FD, location, kind::function, exposure::unexported_public);
+    return finish(idt::statistics::reported);
+  }
+
+  bool VisitClassTemplateDecl(clang::ClassTemplateDecl *CTD) {
+    if (!extern_templates || !CTD->isThisDeclarationADefinition())
+      return true;
+
+    clang::FullSourceLoc location = get_location(CTD);
+
+    // Ignore declarations from the system.
+    if (source_manager_.isInSystemHeader(location))
+      return true;
+
+    // Member templates of class templates cannot be instantiated explicitly.
+    if (CTD->getDeclContext()->isDependentContext())
+      return true;
+
+    clang::SourceLocation end = clang::Lexer::findLocationAfterToken(
+        CTD->getTemplatedDecl()->getBraceRange().getEnd(), clang::tok::semi,
+        source_manager_, context_.getLangOpts(),
+        /*SkipTrailingWhitespaceAndNewLine=*/false);
+
+    instantiations(CTD->specializations(), end,
+                   [&](const clang::ClassTemplateSpecializationDecl *CTSD,
+                       idt::inventory::instantiation &instantiation) {
+                     // Only instantiated definitions are of interest.
+                     if (!CTSD->hasDefinition())
+                       return false;
+
+                     instantiation.key = CTSD->getKindName().str();
+                     llvm::raw_string_ostream OS{instantiation.declaration};
+                     OS << CTSD->getKindName() << " ";
+                     CTSD->getNameForDiagnostic(
+                         OS, context_.getPrintingPolicy(), /*Qualified=*/true);
+                     OS.flush();
+                     return true;
+                   });
+    return true;
+  }
+
+  bool VisitFunctionTemplateDecl(clang::FunctionTemplateDecl *FTD) {
+    if (!extern_templates || !FTD->isThisDeclarationADefinition())
+      return true;
+
+    clang::FullSourceLoc location = get_location(FTD);
+
+    // Ignore declarations from the system.
+    if (source_manager_.isInSystemHeader(location))
+      return true;
+
+    // Member templates of class templates cannot be instantiated explicitly.
+    if (FTD->getDeclContext()->isDependentContext())
+      return true;
+
+    // Constructors and conversions cannot be spelt as a declaration.
+    if (llvm::isa<clang::CXXConstructorDecl, clang::CXXConversionDecl>(
+            FTD->getTemplatedDecl()))
+      return true;
+
+    clang::SourceLocation end = clang::Lexer::getLocForEndOfToken(
+        FTD->getTemplatedDecl()->getEndLoc(), 0, source_manager_,
+        context_.getLangOpts());
+
+    instantiations(FTD->specializations(), end,
+                   [&](const clang::FunctionDecl *FD,
+                       idt::inventory::instantiation &instantiation) {
+                     // Only instantiated definitions are of interest, and a
+                     // deduced return type cannot be spelt.
+                     if (!FD->isDefined() ||
+                         FD->getDeclaredReturnType()->getContainedDeducedType())
+                       return false;
+
+                     const clang::PrintingPolicy &policy =
+                         context_.getPrintingPolicy();
+                     llvm::raw_string_ostream OS{instantiation.declaration};
+                     OS << FD->getReturnType().getAsString(policy) << " ";
+                     FD->getNameForDiagnostic(OS, policy, /*Qualified=*/true);
+                     OS << "(";
+                     llvm::interleaveComma(
+                         FD->parameters(), OS,
+                         [&](const clang::ParmVarDecl *PVD) {
+                           OS << PVD->getType().getAsString(policy);
+                         });
+                     if (FD->isVariadic())
+                       OS << (FD->param_empty() ? "..." : ", ...");
+                     OS << ")";
+                     if (const auto *MD =
+                             llvm::dyn_cast<clang::CXXMethodDecl>(FD))
+                       if (MD->isConst())
+                         OS << " const";
+                     OS.flush();
+                     return true;
+                   });
+    return true;
+  }
+
+  void exported_inline(const clang::FunctionDecl *FD, const clang::Attr *A,
+                       clang::FullSourceLoc location) {
+    // An attribute inherited from the class cannot be removed from the
+    // function alone.
+    if (A->isInherited() || A->getRange().isInvalid())
+      report(finding::exported_inline_interface, location, FD);
+    else
+      report(finding::exported_inline_interface, location, FD,
+             clang::FixItHint::CreateRemoval(
+                 source_manager_.getExpansionRange(A->getRange())));
+
+    record(FD, location, kind::function,
+           FD->getAccess() == clang::AccessSpecifier::AS_private
+               ? exposure::exported_private
+               : exposure::exported,
+           /*inline_function=*/true);
+  }
+
+  bool VisitVarDecl(clang::VarDecl *VD) {
+    clang::FullSourceLoc location = get_location(VD);
+
+    // Only namespace scope variables can be given internal linkage.
+    if (internal_linkage && VD->isFileVarDecl() &&
+        !VD->isStaticDataMember() && !VD->isInline() &&
+        !VD->getDeclContext()->isDependentContext() &&
+        !VD->getDescribedVarTemplate() &&
+        !llvm::isa<clang::VarTemplateSpecializationDecl>(VD))
+      linkage(VD);
+
+    // Clients only contribute references to the library.
+    if (client_) {
+      reference(VD, location);
+      return true;
+    }
+
+    // Ignore declarations from the system.
+    if (source_manager_.isInSystemHeader(location))
+      return true;
+
+    // Only global variables and static data members can be imported.  A
+    // declaration in a single-line linkage specification (`extern "C"`) has
+    // no storage class, but is no more a definition than an `extern` one.
+    if (VD->isLocalVarDeclOrParm() || VD->isLocalExternDecl())
+      return true;
+    if (VD->isThisDeclarationADefinition() != clang::VarDecl::DeclarationOnly)
+      return true;
+
+    // Thread-local variables cannot be imported or exported.
+    if (VD->getTLSKind() != clang::VarDecl::TLS_None)
+      return true;
+
+    // We are only interested in non-dependent types.
+    if (VD->getDeclContext()->isDependentContext() ||
+        VD->getDescribedVarTemplate())
+      return true;
+
+    // If the variable is defined, it can be materialized by the user.
+    if (VD->hasDefinition() != clang::VarDecl::DeclarationOnly)
+      return true;
+
+    // Constants initialized in-class are usable without a definition.
+    if (VD->hasInit())
+      return true;
+
+    // Ignore private members (except for a negative check).
+    if (VD->isStaticDataMember() &&
+        VD->getAccess() == clang::AccessSpecifier::AS_private) {
+      if (VD->hasAttr<clang::DLLExportAttr>()) {
+        report(finding::exported_private_interface, location, VD);
+        record(VD, location, kind::variable, exposure::exported_private);
+      }
+      return true;
+    }
+
+    // If the variable has a dll-interface, it is properly annotated.
+    if (VD->hasAttr<clang::DLLExportAttr>() ||
+        VD->hasAttr<clang::DLLImportAttr>()) {
+      record(VD, location, kind::variable, exposure::exported);
+      return true;
+    }
+
+    if (contains(get_ignored_functions(), VD->getNameAsString()))
+      return true;
+
+    // The members of a class which is to be exported as a whole are exported
+    // with it, and cannot also be exported individually.
+    if (const auto *RD =
+            llvm::dyn_cast<clang::CXXRecordDecl>(VD->getDeclContext()))
+      if (suggests_class_export(RD)) {
+        record(VD, location, kind::variable, exposure::unexported_public);
+        return true;
+      }
+
+    report(finding::unexported_public_interface, location, VD,
+           clang::FixItHint::CreateInsertion(VD->getBeginLoc(),
+                                             export_macro + " "));
+    record(VD, location, kind::variable, exposure::unexported_public);
+    return true;
+  }
+
+  bool VisitCXXRecordDecl(clang::CXXRecordDecl *RD) {
+    if (client_)
+      return true;
+
+    clang::FullSourceLoc location = get_location(RD);
+
+    // Ignore declarations from the system.
+    if (source_manager_.isInSystemHeader(location))
+      return true;
+
+    // We are only interested in named, non-dependent class definitions.
+    if (RD->isImplicit() || !RD->isThisDeclarationADefinition() ||
+        RD->isDependentContext() || RD->isLambda() || RD->isLocalClass() ||
+        !RD->getIdentifier())
+      return true;
+
+    bool exported = RD->hasAttr<clang::DLLExportAttr>() ||
+                    RD->hasAttr<clang::DLLImportAttr>();
+
+    if (RD->getAccess() == clang::AccessSpecifier::AS_private) {
+      if (exported)
+        record(RD, location, kind::record, exposure::exported_private);
+      return true;
+    }
+
+    // A class contributes to the export surface through its vtable and type
+    // information, which only polymorphic classes require.  Other classes
+    // only need their out-of-line members to be exported.
+    if (!RD->isDynamicClass()) {
+      if (exported) {
+        record(RD, location, kind::record, exposure::exported);
+        member_level_export(RD, location);
+      }
+      return true;
+    }
+
+    if (exported) {
+      record(RD, location, kind::record, exposure::exported);
+      return true;
+    }
+
+    if (suggests_class_export(RD))
+      report(finding::unexported_polymorphic_class, location, RD,
+             clang::FixItHint::CreateInsertion(RD->getLocation(),
+                                               export_macro + " "));
+    else
+      report(finding::polymorphic_class_without_key_function, location, RD);
+    record(RD, location, kind::record, exposure::unexported_public);
+    return true;
+  }
+
+  // Returns whether the class-level export of `RD` is suggested, which also
+  // exports its members: `RD` is an unexported polymorphic class whose vtable
+  // is emitted with its key function.  Without a key function, the vtable is
+  // emitted into every translation unit which requires it, and no export can
+  // make it single-instance.
+  bool suggests_class_export(const clang::CXXRecordDecl *RD) const {
+    RD = RD->getDefinition();
+    if (!RD || RD->isDependentContext() || RD->isLambda() ||
+        RD->isLocalClass() || !RD->getIdentifier() ||
+        RD->getAccess() == clang::AccessSpecifier::AS_private)
+      return false;
+    if (!RD->isDynamicClass() || RD->hasAttr<clang::DLLExportAttr>() ||
+        RD->hasAttr<clang::DLLImportAttr>())
+      return false;
+    return !context_.getTargetInfo().getCXXABI().hasKeyFunctions() ||
+           context_.getCurrentKeyFunction(RD);
+  }
+
+  // Suggest replacing the class-level export of a non-polymorphic class with
+  // exporting the members which are defined out-of-line, which avoids
+  // exporting the inline and implicit members.
+  void member_level_export(const clang::CXXRecordDecl *RD,
+                           clang::FullSourceLoc location) {
+    const clang::Attr *A = RD->getAttr<clang::DLLExportAttr>();
+    if (!A)
+      A = RD->getAttr<clang::DLLImportAttr>();
+    if (!A || A->isInherited() || A->getRange().isInvalid())
+      return;
+
+    llvm::SmallVector<clang::FixItHint, 4> fixits{
+        clang::FixItHint::CreateRemoval(
+            source_manager_.getExpansionRange(A->getRange()))};
+
+    for (const clang::Decl *D : RD->decls()) {
+      if (D->isImplicit() ||
+          D->getAccess() == clang::AccessSpecifier::AS_private)
+        continue;
+
+      if (const auto *MD = llvm::dyn_cast<clang::CXXMethodDecl>(D)) {
+        if (MD->hasBody() || MD->isPure() || MD->isDeleted() ||
+            MD->isDefaulted())
+          continue;
+      } else if (const auto *VD = llvm::dyn_cast<clang::VarDecl>(D)) {
+        if (VD->hasInit() ||
+            VD->hasDefinition() != clang::VarDecl::DeclarationOnly)
+          continue;
+      } else {
+        continue;
+      }
+
+      fixits.push_back(clang::FixItHint::CreateInsertion(D->getBeginLoc(),
+                                                         export_macro + " "));
+    }
+
+    report(finding::member_level_interface, location, RD, fixits);
+  }
+};
+}
+
+#endif
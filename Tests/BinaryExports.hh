@@ -0,0 +1,35 @@
+// RUN: %yaml2obj %S/Inputs/BinaryExports.elf.yaml -o %t.so
+// RUN: %idt -export-macro IDT_TEST_ABI -binary %t.so %s -- --target=x86_64-w64-windows-gnu | %FileCheck %s -check-prefix CHECK-ELF
+// RUN: %yaml2obj %S/Inputs/BinaryExports.coff.yaml -o %t.dll
+// RUN: %idt -export-macro IDT_TEST_ABI -binary %t.dll %s -- --target=x86_64-unknown-windows-msvc | %FileCheck %s -check-prefix CHECK-COFF
+// RUN: not %idt -export-macro IDT_TEST_ABI -binary %t.missing %s 2>&1 | %FileCheck %s
+
+// The shared object is checked against the declarations for MinGW, which uses
+// the Itanium C++ ABI.  Both binaries also export an undeclared function and
+// symbols with vague linkage: the implicit members of `record`, an inline
+// function, and the vtable, type information and guard variables of classes
+// which the headers do not declare.
+
+// CHECK-ELF: binary '{{.*}}.so': 11 exported symbols, 1 over-exported, 1 missing
+// CHECK-ELF-NEXT: over-exported symbol 'undeclared_function()' (_Z19undeclared_functionv) is not declared by any header
+
+// CHECK-COFF: binary '{{.*}}.dll': 9 exported symbols, 1 over-exported, 1 missing
+// CHECK-COFF-NEXT: over-exported symbol 'void __cdecl undeclared_function(void)' (?undeclared_function@@YAXXZ) is not declared by any header
+
+#define IDT_TEST_ABI __attribute__((__dllexport__))
+
+IDT_TEST_ABI void exported_function();
+
+IDT_TEST_ABI extern int exported_variable;
+
+IDT_TEST_ABI void missing_function();
+// CHECK-ELF-NEXT: missing symbol 'missing_function' (_Z16missing_functionv) declared at {{.*}}BinaryExports.hh:[[@LINE-1]]
+// CHECK-COFF-NEXT: missing symbol 'missing_function' (?missing_function@@YAXXZ) declared at {{.*}}BinaryExports.hh:[[@LINE-2]]
+
+struct IDT_TEST_ABI record {
+  record();
+};
+
+void function();
+
+// CHECK: error: {{.*}}.missing: {{[Nn]}}o such file or directory
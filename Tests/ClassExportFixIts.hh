@@ -0,0 +1,25 @@
+// RUN: cat %s > %t.hh
+// RUN: %idt -export-macro IDT_TEST_ABI -apply-fixits -inplace %t.hh -- --target=x86_64-unknown-windows-msvc
+// RUN: %FileCheck %s < %t.hh
+// RUN: %idt -export-macro IDT_TEST_ABI %t.hh -- --target=x86_64-unknown-windows-msvc 2>&1 | %FileCheck %s -check-prefix CHECK-REWRITTEN -allow-empty
+
+// The class-level export of a polymorphic class also exports its members, so
+// they are not exported individually as well, which would be rejected.
+
+#define IDT_TEST_ABI __declspec(dllexport)
+
+struct polymorphic_record {
+  virtual ~polymorphic_record();
+  void method();
+  static int member;
+};
+// CHECK: {{^}}struct IDT_TEST_ABI polymorphic_record {
+// CHECK-NEXT: {{^}}  virtual ~polymorphic_record();
+// CHECK-NEXT: {{^}}  void method();
+// CHECK-NEXT: {{^}}  static int member;
+
+void function();
+// CHECK: {{^}}IDT_TEST_ABI void function();
+
+// CHECK-REWRITTEN-NOT: error:
+// CHECK-REWRITTEN-NOT: remark:
@@ -0,0 +1,21 @@
+// RUN: %idt -export-macro IDT_TEST_ABI -client %S/Inputs/ClientUsage.cc %s -- --target=x86_64-unknown-windows-msvc 2>&1 | %FileCheck %s
+// RUN: cd %S && %idt -export-macro IDT_TEST_ABI -client Inputs/ClientUsage.cc ClientUsage.hh -- --target=x86_64-unknown-windows-msvc 2>&1 | %FileCheck %s
+// RUN: cd %S && %idt -export-macro IDT_TEST_ABI -j 2 -client Inputs/ClientUsage.cc ClientUsage.hh -- --target=x86_64-unknown-windows-msvc 2>&1 | %FileCheck %s
+
+#pragma once
+
+#define IDT_TEST_ABI __declspec(dllexport)
+
+IDT_TEST_ABI void used_function();
+// CHECK-NOT: unused export 'used_function'
+
+IDT_TEST_ABI void unused_function();
+// CHECK: unused export 'unused_function' declared at {{.*}}ClientUsage.hh:[[@LINE-1]] is not referenced by any client
+
+IDT_TEST_ABI extern int used_variable;
+// CHECK-NOT: unused export 'used_variable'
+
+IDT_TEST_ABI extern int unused_variable;
+// CHECK: unused export 'unused_variable' declared at {{.*}}ClientUsage.hh:[[@LINE-1]] is not referenced by any client
+
+// CHECK: 2 of 4 exports are not referenced by any of 1 clients
@@ -0,0 +1,36 @@
+// RUN: %idt -export-macro IDT_TEST_ABI -export-report %s -- --target=x86_64-unknown-windows-msvc 2>&1 | %FileCheck %s
+// RUN: not %idt -export-macro IDT_TEST_ABI -max-exports 4 %s -- --target=x86_64-unknown-windows-msvc 2>&1 | %FileCheck %s -check-prefix CHECK-OVER-BUDGET
+// RUN: %idt -export-macro IDT_TEST_ABI -max-exports IDT_TEST_ABI=5 %s -- --target=x86_64-unknown-windows-msvc 2>&1 | %FileCheck %s -check-prefix CHECK-WITHIN-BUDGET
+
+#define IDT_TEST_ABI __declspec(dllexport)
+
+IDT_TEST_ABI void exported_function();
+void unexported_function();
+
+IDT_TEST_ABI extern int exported_variable;
+extern int unexported_variable;
+
+class IDT_TEST_ABI exported_record {
+public:
+  void method();
+};
+
+struct polymorphic_record {
+  virtual ~polymorphic_record();
+};
+
+class record {
+  IDT_TEST_ABI void private_method();
+};
+
+// The destructor of `polymorphic_record` is exported with the class, and is
+// only counted with it.
+// CHECK: library 'IDT_TEST_ABI': 5 exported symbols
+// CHECK-NEXT:   functions: 2 exported, 1 unexported public, 1 exported private
+// CHECK-NEXT:   variables: 1 exported, 1 unexported public, 0 exported private
+// CHECK-NEXT:   classes: 1 exported, 1 unexported public, 0 exported private
+// CHECK: header '{{.*}}ExportReport.hh' (library 'IDT_TEST_ABI'): 5 exported symbols
+
+// CHECK-OVER-BUDGET: error: library 'IDT_TEST_ABI' exports 5 symbols, exceeding the budget of 4
+
+// CHECK-WITHIN-BUDGET-NOT: error: library 'IDT_TEST_ABI'
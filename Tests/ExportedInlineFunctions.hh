@@ -0,0 +1,24 @@
+// RUN: %idt -export-macro IDT_TEST_ABI -export-report %s -- --target=x86_64-unknown-windows-msvc 2>&1 | %FileCheck %s
+
+#define IDT_TEST_ABI __declspec(dllexport)
+
+IDT_TEST_ABI inline void exported_inline_function() {}
+// CHECK: ExportedInlineFunctions.hh:[[@LINE-1]]:1: remark: exported inline interface 'exported_inline_function'
+
+IDT_TEST_ABI constexpr int exported_constexpr_function() { return 0; }
+// CHECK: ExportedInlineFunctions.hh:[[@LINE-1]]:1: remark: exported inline interface 'exported_constexpr_function'
+
+inline void inline_function() {}
+// CHECK-NOT: remark: exported inline interface 'inline_function'
+
+class IDT_TEST_ABI exported_record {
+public:
+  void inline_method() {}
+// CHECK: ExportedInlineFunctions.hh:[[@LINE-1]]:3: remark: exported inline interface 'inline_method'
+
+  void method();
+// CHECK-NOT: remark: exported inline interface 'method'
+};
+
+// CHECK: library 'IDT_TEST_ABI': 5 exported symbols
+// CHECK: exported inline functions: 3 (3 symbols could be saved)
@@ -0,0 +1,39 @@
+// RUN: %idt -export-macro IDT_TEST_ABI -extern-templates %s %S/Inputs/ExternTemplates.cc -- 2>&1 | %FileCheck %s
+// RUN: %idt -export-macro IDT_TEST_ABI -extern-templates -extern-template-threshold 1 %s %S/Inputs/ExternTemplates.cc -- 2>&1 | %FileCheck %s -check-prefix CHECK-CLIENT
+
+#pragma once
+
+template <typename T>
+struct record {
+  T value;
+};
+
+template <typename T>
+T identity(T value) { return value; }
+
+inline record<int> make_record() { return { identity(0) }; }
+
+struct payload {};
+
+inline record<payload> make_payload_record() { return {}; }
+
+// CHECK: template 'int identity<int>(int)' is implicitly instantiated in 2 translation units
+// CHECK-NEXT:   header: extern template IDT_TEST_ABI int identity<int>(int);
+// CHECK-NEXT:   source: template IDT_TEST_ABI int identity<int>(int);
+// CHECK-NEXT: fix-it:"{{.*}}ExternTemplates.hh":{12:38-12:38}:"\nextern template IDT_TEST_ABI int identity<int>(int);"
+// CHECK: template 'struct record<int>' is implicitly instantiated in 2 translation units
+// CHECK-NEXT:   header: extern template struct IDT_TEST_ABI record<int>;
+// CHECK-NEXT:   source: template struct IDT_TEST_ABI record<int>;
+// CHECK-NEXT: fix-it:"{{.*}}ExternTemplates.hh":{9:3-9:3}:"\nextern template struct IDT_TEST_ABI record<int>;"
+
+// The extern template declaration follows the declaration of its argument.
+// CHECK: template 'struct record<payload>' is implicitly instantiated in 2 translation units
+// CHECK-NEXT:   header: extern template struct IDT_TEST_ABI record<payload>;
+// CHECK-NEXT:   source: template struct IDT_TEST_ABI record<payload>;
+// CHECK-NEXT: fix-it:"{{.*}}ExternTemplates.hh":{16:19-16:19}:"\nextern template struct IDT_TEST_ABI record<payload>;"
+
+// An argument which the header cannot name is not suggested as a fix-it.
+// CHECK-CLIENT: template 'client_value identity<client_value>(client_value)' is implicitly instantiated in 1 translation units
+// CHECK-CLIENT-NEXT:   header: extern template IDT_TEST_ABI client_value identity<client_value>(client_value);
+// CHECK-CLIENT-NEXT:   source: template IDT_TEST_ABI client_value identity<client_value>(client_value);
+// CHECK-CLIENT-NOT: fix-it:
@@ -0,0 +1,49 @@
+// RUN: %idt -export-macro IDT_TEST_ABI %s -- -fdiagnostics-parseable-fixits 2>&1 | %FileCheck %s
+
+extern int extern_variable;
+// CHECK: ExternVariables.hh:[[@LINE-1]]:1: remark: unexported public interface 'extern_variable'
+// CHECK: fix-it:"{{.*}}ExternVariables.hh":{[[@LINE-2]]:1-[[@LINE-2]]:1}:"IDT_TEST_ABI "
+
+extern "C" int extern_c_variable;
+// CHECK: ExternVariables.hh:[[@LINE-1]]:12: remark: unexported public interface 'extern_c_variable'
+// CHECK: fix-it:"{{.*}}ExternVariables.hh":{[[@LINE-2]]:12-[[@LINE-2]]:12}:"IDT_TEST_ABI "
+
+extern int defined_variable;
+int defined_variable = 0;
+// CHECK-NOT: ExternVariables.hh:[[@LINE-2]]:1: remark: unexported public interface 'defined_variable'
+
+static int internal_variable;
+// CHECK-NOT: ExternVariables.hh:[[@LINE-1]]:1: remark: unexported public interface 'internal_variable'
+
+extern thread_local int thread_local_variable;
+// CHECK-NOT: ExternVariables.hh:[[@LINE-1]]:1: remark: unexported public interface 'thread_local_variable'
+
+struct record {
+  static int static_member;
+// CHECK: ExternVariables.hh:[[@LINE-1]]:3: remark: unexported public interface 'static_member'
+// CHECK: fix-it:"{{.*}}ExternVariables.hh":{[[@LINE-2]]:3-[[@LINE-2]]:3}:"IDT_TEST_ABI "
+
+  static const int constant_member = 1;
+// CHECK-NOT: ExternVariables.hh:[[@LINE-1]]:3: remark: unexported public interface 'constant_member'
+
+  static constexpr int constexpr_member = 1;
+// CHECK-NOT: ExternVariables.hh:[[@LINE-1]]:3: remark: unexported public interface 'constexpr_member'
+
+  static thread_local int thread_local_member;
+// CHECK-NOT: ExternVariables.hh:[[@LINE-1]]:3: remark: unexported public interface 'thread_local_member'
+
+private:
+  static int private_member;
+// CHECK-NOT: ExternVariables.hh:[[@LINE-1]]:3: remark: unexported public interface 'private_member'
+};
+
+template <typename T>
+struct template_record {
+  static T template_member;
+// CHECK-NOT: ExternVariables.hh:[[@LINE-1]]:3: remark: unexported public interface 'template_member'
+};
+
+void function(int parameter) {
+  extern int local_extern_variable;
+// CHECK-NOT: ExternVariables.hh:[[@LINE-1]]:3: remark: unexported public interface 'local_extern_variable'
+}
@@ -0,0 +1,20 @@
+// RUN: %idt -export-macro IDT_TEST_ABI -inline-data-access %s %S/Inputs/InlineDataAccess.cc -- --target=x86_64-unknown-windows-msvc 2>&1 | %FileCheck %s
+
+#pragma once
+
+#define IDT_TEST_ABI __declspec(dllimport)
+
+IDT_TEST_ABI extern int imported_variable;
+
+struct IDT_TEST_ABI record {
+  static int imported_member;
+};
+
+inline int hot_accessor() { return imported_variable; }
+// CHECK: inline function 'hot_accessor' at {{.*}}InlineDataAccess.hh:[[@LINE-1]] accesses imported data 'imported_variable' and is used in 1 translation units
+
+inline int cold_accessor() { return record::imported_member + imported_variable; }
+// CHECK: inline function 'cold_accessor' at {{.*}}InlineDataAccess.hh:[[@LINE-1]] accesses imported data 'record::imported_member', 'imported_variable' and is used in 0 translation units
+
+inline int unrelated_function() { return 0; }
+// CHECK-NOT: inline function 'unrelated_function'
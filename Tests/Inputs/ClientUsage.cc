@@ -0,0 +1,6 @@
+#include "../ClientUsage.hh"
+
+int client() {
+  used_function();
+  return used_variable;
+}
@@ -0,0 +1,8 @@
+#include "../ExternTemplates.hh"
+
+struct client_value {};
+
+int client() {
+  identity(client_value{});
+  return make_record().value + identity(1);
+}
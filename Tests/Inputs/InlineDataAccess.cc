@@ -0,0 +1,5 @@
+#include "../InlineDataAccess.hh"
+
+int client() {
+  return hot_accessor();
+}
@@ -0,0 +1,17 @@
+#include "../InternalLinkage.hh"
+
+int counter = 0;
+
+int record::member = 0;
+
+int helper(int value) {
+  return value + counter + record::member;
+}
+
+int api(int value) {
+  return helper(value);
+}
+
+int unused(int value) {
+  return value;
+}
@@ -0,0 +1,5 @@
+#include "../InternalLinkage.hh"
+
+int client() {
+  return api(1);
+}
@@ -0,0 +1,4 @@
+#define IDT_TEST_ABI __declspec(dllexport)
+
+#include "first/first.h"
+#include "second/second.h"
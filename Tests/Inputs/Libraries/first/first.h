@@ -0,0 +1,6 @@
+#pragma once
+
+IDT_TEST_ABI void first_function();
+void unexported_first_function();
+
+IDT_TEST_ABI extern int first_variable;
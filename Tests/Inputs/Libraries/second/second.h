@@ -0,0 +1,6 @@
+#pragma once
+
+IDT_TEST_ABI void second_function();
+IDT_TEST_ABI void other_second_function();
+
+IDT_TEST_ABI extern int second_variable;
@@ -0,0 +1 @@
+#include "../ParallelOutput.hh"
@@ -0,0 +1,3 @@
+#include "../Progress.hh"
+
+void exported_function() {}
@@ -0,0 +1 @@
+#include <Sarif.h>
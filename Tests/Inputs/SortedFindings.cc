@@ -0,0 +1,5 @@
+#include "../SortedFindings.hh"
+
+void source_function();
+
+#warning "source translation unit"
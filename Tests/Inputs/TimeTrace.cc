@@ -0,0 +1,3 @@
+#include "../TimeTrace.hh"
+
+void unexported_function() {}
@@ -0,0 +1,20 @@
+// RUN: %idt -export-macro IDT_TEST_ABI -internal-linkage %S/Inputs/InternalLinkageDefinitions.cc %S/Inputs/InternalLinkageUses.cc -- 2>&1 | %FileCheck %s
+
+#pragma once
+
+int helper(int value);
+// CHECK: 'helper' declared at {{.*}}InternalLinkage.hh:[[@LINE-1]] is only referenced from its defining translation unit '{{.*}}InternalLinkageDefinitions.cc'; consider internal linkage or a private header
+
+int api(int value);
+// CHECK-NOT: 'api' declared at
+
+extern int counter;
+// CHECK: 'counter' declared at {{.*}}InternalLinkage.hh:[[@LINE-1]] is only referenced from its defining translation unit '{{.*}}InternalLinkageDefinitions.cc'; consider internal linkage or a private header
+
+int unused(int value);
+// CHECK-NOT: 'unused' declared at
+
+struct record {
+  static int member;
+};
+// CHECK-NOT: 'record::member' declared at
@@ -0,0 +1,24 @@
+// RUN: %idt -export-macro IDT_TEST_ABI -format jsonl %s -- --target=x86_64-unknown-windows-msvc 2>%t.stderr | %FileCheck %s
+// RUN: %FileCheck %s -check-prefix CHECK-STDERR -allow-empty < %t.stderr
+
+#define IDT_TEST_ABI __declspec(dllexport)
+
+namespace outer {
+void unexported_function();
+// CHECK: {"kind":"unexported-public-interface","file":"{{.*}}JsonLines.hh","line":[[@LINE-1]],"column":1,"name":"outer::unexported_function","usr":"c:@N@outer@F@unexported_function#","fixits":[{"file":"{{.*}}JsonLines.hh","offset":{{[0-9]+}},"length":0,"text":"IDT_TEST_ABI "}],"unit":"{{.*}}JsonLines.hh"}
+
+extern int unexported_variable;
+// CHECK: {"kind":"unexported-public-interface","file":"{{.*}}JsonLines.hh","line":[[@LINE-1]],"column":1,"name":"outer::unexported_variable","usr":"c:@N@outer@unexported_variable","fixits":[{"file":"{{.*}}JsonLines.hh","offset":{{[0-9]+}},"length":0,"text":"IDT_TEST_ABI "}],"unit":"{{.*}}JsonLines.hh"}
+
+IDT_TEST_ABI inline void exported_inline_function() {}
+// CHECK: {"kind":"exported-inline-interface","file":"{{.*}}JsonLines.hh","line":[[@LINE-1]],"column":1,"name":"outer::exported_inline_function","usr":"c:@N@outer@F@exported_inline_function#","fixits":[{"file":"{{.*}}JsonLines.hh","offset":{{[0-9]+}},"length":12,"text":""}],"unit":"{{.*}}JsonLines.hh"}
+
+// The class-level export is removed, and the member is exported instead.
+class IDT_TEST_ABI exported_record {
+public:
+  void method();
+};
+// CHECK: {"kind":"member-level-interface","file":"{{.*}}JsonLines.hh","line":[[@LINE-4]],"column":1,"name":"outer::exported_record","usr":"c:@N@outer@S@exported_record","fixits":[{"file":"{{.*}}JsonLines.hh","offset":{{[0-9]+}},"length":12,"text":""},{"file":"{{.*}}JsonLines.hh","offset":{{[0-9]+}},"length":0,"text":"IDT_TEST_ABI "}],"unit":"{{.*}}JsonLines.hh"}
+}
+
+// CHECK-STDERR-NOT: remark:
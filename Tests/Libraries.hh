@@ -0,0 +1,22 @@
+// RUN: %idt -export-macro IDT_TEST_ABI -library first=%S/Inputs/Libraries/first -library second=%S/Inputs/Libraries/second -export-report %S/Inputs/Libraries/Libraries.cc -- --target=x86_64-unknown-windows-msvc 2>&1 | %FileCheck %s
+// RUN: not %idt -export-macro IDT_TEST_ABI -library first=%S/Inputs/Libraries/first -library second=%S/Inputs/Libraries/second -max-exports first=1 %S/Inputs/Libraries/Libraries.cc -- --target=x86_64-unknown-windows-msvc 2>&1 | %FileCheck %s -check-prefix CHECK-BUDGET
+// RUN: not %idt -export-macro IDT_TEST_ABI -library first=%S/Inputs/Libraries/first -library second=%S/Inputs/Libraries/second -max-exports third=1 %S/Inputs/Libraries/Libraries.cc -- --target=x86_64-unknown-windows-msvc 2>&1 | %FileCheck %s -check-prefix CHECK-UNKNOWN
+
+// The headers of each library are in a directory of their own, and only the
+// first library has a budget.
+
+// CHECK: library 'first': 2 exported symbols
+// CHECK-NEXT:   functions: 1 exported, 1 unexported public, 0 exported private
+// CHECK-NEXT:   variables: 1 exported, 0 unexported public, 0 exported private
+// CHECK-NEXT:   classes: 0 exported, 0 unexported public, 0 exported private
+// CHECK-NEXT: library 'second': 3 exported symbols
+// CHECK-NEXT:   functions: 2 exported, 0 unexported public, 0 exported private
+// CHECK-NEXT:   variables: 1 exported, 0 unexported public, 0 exported private
+// CHECK-NEXT:   classes: 0 exported, 0 unexported public, 0 exported private
+// CHECK-NEXT: header '{{.*}}first.h' (library 'first'): 2 exported symbols
+// CHECK: header '{{.*}}second.h' (library 'second'): 3 exported symbols
+
+// CHECK-BUDGET: error: library 'first' exports 2 symbols, exceeding the budget of 1
+// CHECK-BUDGET-NOT: error: library 'second'
+
+// CHECK-UNKNOWN: error: export budget for unknown library 'third'
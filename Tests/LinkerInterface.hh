@@ -0,0 +1,53 @@
+// RUN: %idt -export-macro IDT_TEST_ABI -module-name ids -emit-module-definition %t.def %s -- --target=x86_64-unknown-windows-msvc
+// RUN: %FileCheck %s -check-prefix CHECK-DEF < %t.def
+// RUN: cat %S/Inputs/LinkerInterface.def > %t.existing.def
+// RUN: %idt -export-macro IDT_TEST_ABI -module-name ids -emit-module-definition %t.existing.def %s -- --target=x86_64-unknown-windows-msvc
+// RUN: %FileCheck %s -check-prefix CHECK-ORDINALS < %t.existing.def
+// RUN: %idt -export-macro IDT_TEST_ABI -emit-version-script %t.map %s -- --target=x86_64-unknown-linux-gnu
+// RUN: %FileCheck %s -check-prefix CHECK-MAP < %t.map
+
+void function();
+extern int variable;
+
+inline void inline_function() {}
+
+class record {
+  void private_method();
+};
+
+struct polymorphic_record {
+  virtual ~polymorphic_record();
+};
+
+// CHECK-DEF: LIBRARY ids
+// CHECK-DEF-NEXT: EXPORTS
+// CHECK-DEF-NEXT:   ??1polymorphic_record@@UEAA@XZ @1
+// CHECK-DEF-NEXT:   ??_7polymorphic_record@@6B@ @2 DATA
+// CHECK-DEF-NEXT:   ?function@@YAXXZ @3
+// CHECK-DEF-NEXT:   ?variable@@3HA @4 DATA
+// CHECK-DEF-NOT: inline_function
+// CHECK-DEF-NOT: private_method
+
+// The ordinals of an existing module-definition file are preserved, and the
+// ordinals of removed symbols are not reused.
+// CHECK-ORDINALS: LIBRARY ids
+// CHECK-ORDINALS-NEXT: EXPORTS
+// CHECK-ORDINALS-NEXT:   ??1polymorphic_record@@UEAA@XZ @4
+// CHECK-ORDINALS-NEXT:   ??_7polymorphic_record@@6B@ @5 DATA
+// CHECK-ORDINALS-NEXT:   ?function@@YAXXZ @3
+// CHECK-ORDINALS-NEXT:   ?variable@@3HA @1 DATA
+// CHECK-ORDINALS-NOT: removed_function
+
+// CHECK-MAP: {
+// CHECK-MAP-NEXT:   global:
+// CHECK-MAP-NEXT:     _Z8functionv;
+// CHECK-MAP-NEXT:     _ZN18polymorphic_recordD0Ev;
+// CHECK-MAP-NEXT:     _ZN18polymorphic_recordD1Ev;
+// CHECK-MAP-NEXT:     _ZN18polymorphic_recordD2Ev;
+// CHECK-MAP-NEXT:     _ZTI18polymorphic_record;
+// CHECK-MAP-NEXT:     _ZTS18polymorphic_record;
+// CHECK-MAP-NEXT:     _ZTV18polymorphic_record;
+// CHECK-MAP-NEXT:     variable;
+// CHECK-MAP-NEXT:   local:
+// CHECK-MAP-NEXT:     *;
+// CHECK-MAP-NEXT: };
@@ -0,0 +1,12 @@
+// RUN: %idt -export-macro IDT_TEST_ABI -j 2 %s %S/Inputs/ParallelOutput.cc -- --target=x86_64-unknown-windows-msvc 2>&1 | %FileCheck %s
+// RUN: %idt -export-macro IDT_TEST_ABI -j 2 -format jsonl %s %S/Inputs/ParallelOutput.cc -- --target=x86_64-unknown-windows-msvc | %FileCheck %s -check-prefix CHECK-JSONL
+
+#pragma once
+
+void unexported_function();
+
+// CHECK-DAG: ParallelOutput.hh:[[@LINE-2]]:1: remark: unexported public interface 'unexported_function'
+// CHECK-DAG: ParallelOutput.hh:[[@LINE-3]]:1: remark: unexported public interface 'unexported_function'
+
+// CHECK-JSONL-DAG: {"kind":"unexported-public-interface","file":"{{.*}}ParallelOutput.hh","line":[[@LINE-5]],{{.*}}"unit":"{{.*}}ParallelOutput.hh"}
+// CHECK-JSONL-DAG: {"kind":"unexported-public-interface","file":"{{.*}}ParallelOutput.hh","line":[[@LINE-6]],{{.*}}"unit":"{{.*}}ParallelOutput.cc"}
@@ -0,0 +1,40 @@
+// The cost of a scan of a synthetic corpus, measured by deterministic proxies
+// rather than time: the translation units parsed, the files read, and the
+// declarations visited.  A change to these counts is a change in the work
+// performed, and should be deliberate.
+
+// RUN: %python %S/../../Benchmarks/generate-corpus.py --headers 8 --declarations 10 --fan-out 2 --templates 0 --classes 0 --annotated 0.5 --seed 0 %t
+// RUN: %idt -export-macro CORPUS_ABI -export-report -p %t -stats-file %t.json %t/src/source_7.cc %t/src/source_5.cc > %t.report 2> %t.remarks
+// RUN: %FileCheck %s < %t.json
+
+// CHECK: "translation_units": 2,
+// CHECK-NEXT: "files": 12,
+// CHECK-NEXT: "declarations": 230,
+// CHECK-NEXT: "findings": 38,
+// CHECK: "inventory": {
+// CHECK-NEXT: "lookups": 80,
+// CHECK-NEXT: "hits": 30
+// CHECK-NEXT: },
+// CHECK-NEXT: "functions": {
+// CHECK-NEXT: "client": 0,
+// CHECK-NEXT: "system header": 0,
+// CHECK-NEXT: "dependent": 0,
+// CHECK-NEXT: "has body": 2,
+// CHECK-NEXT: "friend": 0,
+// CHECK-NEXT: "deleted/defaulted": 0,
+// CHECK-NEXT: "private": 0,
+// CHECK-NEXT: "pure": 0,
+// CHECK-NEXT: "annotated": 38,
+// CHECK-NEXT: "ignored": 0,
+// CHECK-NEXT: "class export": 0,
+// CHECK-NEXT: "reported": 31
+// CHECK-NEXT: },
+
+// CHECK: "path": "{{.*}}source_7.cc",
+// CHECK: "files": 7,
+// CHECK-NEXT: "declarations": 143,
+// CHECK-NEXT: "findings": 23,
+// CHECK: "path": "{{.*}}source_5.cc",
+// CHECK: "files": 5,
+// CHECK-NEXT: "declarations": 87,
+// CHECK-NEXT: "findings": 15,
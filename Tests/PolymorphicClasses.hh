@@ -0,0 +1,43 @@
+// RUN: %idt -export-macro IDT_TEST_ABI %s -- --target=x86_64-unknown-linux-gnu 2>&1 | %FileCheck %s -check-prefix CHECK-ITANIUM
+// RUN: %idt -export-macro IDT_TEST_ABI %s -- --target=x86_64-unknown-windows-msvc 2>&1 | %FileCheck %s -check-prefix CHECK-MSVC
+
+#if defined(_WIN32)
+#define IDT_TEST_ABI __declspec(dllexport)
+#else
+#define IDT_TEST_ABI
+#endif
+
+struct key_function {
+// CHECK-ITANIUM: PolymorphicClasses.hh:[[@LINE-1]]:1: remark: unexported polymorphic class 'key_function' requires class-level export for its vtable and type information
+// CHECK-MSVC: PolymorphicClasses.hh:[[@LINE-2]]:1: remark: unexported polymorphic class 'key_function' requires class-level export for its vtable and type information
+  virtual ~key_function();
+  void method();
+  static int member;
+// The members are exported with the class.
+// CHECK-ITANIUM-NOT: remark: unexported public interface
+// CHECK-MSVC-NOT: remark: unexported public interface
+};
+
+struct inline_virtual_functions {
+// CHECK-ITANIUM: PolymorphicClasses.hh:[[@LINE-1]]:1: remark: polymorphic class 'inline_virtual_functions' has no key function; its vtable is emitted in every client
+// CHECK-MSVC: PolymorphicClasses.hh:[[@LINE-2]]:1: remark: unexported polymorphic class 'inline_virtual_functions' requires class-level export for its vtable and type information
+  virtual void method() {}
+};
+
+struct IDT_TEST_ABI exported_polymorphic {
+// CHECK-MSVC-NOT: remark: {{.*}} class 'exported_polymorphic'
+  virtual ~exported_polymorphic();
+};
+
+struct plain {
+// CHECK-ITANIUM-NOT: remark: {{.*}} class 'plain'
+// CHECK-MSVC-NOT: remark: {{.*}} class 'plain'
+  void method();
+};
+
+class IDT_TEST_ABI exported_record {
+// CHECK-MSVC: PolymorphicClasses.hh:[[@LINE-1]]:1: remark: non-polymorphic class 'exported_record' only requires member-level export
+public:
+  void method();
+  void inline_method() {}
+};
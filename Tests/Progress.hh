@@ -0,0 +1,10 @@
+// RUN: %idt -export-macro IDT_TEST_ABI -progress %s %S/Inputs/Progress.cc -- --target=x86_64-unknown-windows-msvc 2>&1 | %FileCheck %s
+// RUN: %idt -export-macro IDT_TEST_ABI -progress -j 2 %s %S/Inputs/Progress.cc -- --target=x86_64-unknown-windows-msvc 2>&1 | %FileCheck %s
+
+#pragma once
+
+#define IDT_TEST_ABI __declspec(dllexport)
+
+IDT_TEST_ABI void exported_function();
+
+// CHECK: [2/2] {{[0-9]+}} declarations/s, ETA 00:00
@@ -0,0 +1,99 @@
+// RUN: %idt -export-macro IDT_TEST_ABI -format sarif %s -- --target=x86_64-unknown-windows-msvc > %t.sarif
+// RUN: %python -m json.tool %t.sarif | %FileCheck %s
+// RUN: cd %S/Inputs && %idt -export-macro IDT_TEST_ABI -format sarif %S/Inputs/Sarif.cc -- --target=x86_64-unknown-windows-msvc -I . > %t.relative.sarif
+// RUN: %python -m json.tool %t.relative.sarif | %FileCheck %s -check-prefix CHECK-RELATIVE
+
+#define IDT_TEST_ABI __declspec(dllexport)
+
+// CHECK: "$schema": "https://json.schemastore.org/sarif-2.1.0.json",
+// CHECK-NEXT: "version": "2.1.0",
+// CHECK: "name": "idt",
+// CHECK-NEXT: "rules": [
+// CHECK-NEXT: {
+// CHECK-NEXT: "id": "unexported-public-interface",
+// CHECK: "id": "exported-private-interface",
+// CHECK: "originalUriBaseIds": {
+// CHECK-NEXT: "%SRCROOT%": {
+// CHECK-NEXT: "uri": "file://{{.*}}/"
+// CHECK: "results": [
+
+void unexported_function();
+// CHECK: "ruleId": "unexported-public-interface",
+// CHECK-NEXT: "ruleIndex": 0,
+// CHECK-NEXT: "level": "note",
+// CHECK-NEXT: "message": {
+// CHECK-NEXT: "text": "unexported public interface 'unexported_function'"
+// CHECK: "uri": "file://{{.*}}Sarif.hh"
+// CHECK: "startLine": [[@LINE-7]],
+// CHECK-NEXT: "startColumn": 1
+// CHECK: "fullyQualifiedName": "unexported_function"
+// CHECK: "fixes": [
+// CHECK: "replacements": [
+// CHECK-NEXT: {
+// CHECK-NEXT: "deletedRegion": {
+// CHECK-NEXT: "byteOffset": {{[0-9]+}},
+// CHECK-NEXT: "byteLength": 0
+// CHECK-NEXT: },
+// CHECK-NEXT: "insertedContent": {
+// CHECK-NEXT: "text": "IDT_TEST_ABI "
+// CHECK: "usr": "c:@F@unexported_function#",
+
+class record {
+  IDT_TEST_ABI void exported_private_method();
+// CHECK: "ruleId": "exported-private-interface",
+// CHECK-NEXT: "ruleIndex": 1,
+// CHECK: "text": "exported private interface 'exported_private_method'"
+// CHECK: "startLine": [[@LINE-4]],
+// CHECK: "fullyQualifiedName": "record::exported_private_method"
+// CHECK-NOT: "fixes"
+// CHECK: "usr": "c:@S@record@F@exported_private_method#",
+};
+
+class IDT_TEST_ABI exported_record {
+// CHECK: "ruleId": "member-level-interface",
+// CHECK-NEXT: "ruleIndex": 5,
+// CHECK: "text": "non-polymorphic class 'exported_record' only requires member-level export"
+// CHECK: "startLine": [[@LINE-4]],
+// CHECK: "fullyQualifiedName": "exported_record"
+// The removal of the class-level export and the export of the member are a
+// single fix.
+// CHECK: "fixes": [
+// CHECK-NEXT: {
+// CHECK-NEXT: "artifactChanges": [
+// CHECK-NEXT: {
+// CHECK-NEXT: "artifactLocation": {
+// CHECK-NEXT: "uri": "file://{{.*}}Sarif.hh"
+// CHECK-NEXT: },
+// CHECK-NEXT: "replacements": [
+// CHECK-NEXT: {
+// CHECK-NEXT: "deletedRegion": {
+// CHECK-NEXT: "byteOffset": {{[0-9]+}},
+// CHECK-NEXT: "byteLength": 12
+// CHECK-NEXT: }
+// CHECK-NEXT: },
+// CHECK-NEXT: {
+// CHECK-NEXT: "deletedRegion": {
+// CHECK-NEXT: "byteOffset": {{[0-9]+}},
+// CHECK-NEXT: "byteLength": 0
+// CHECK-NEXT: },
+// CHECK-NEXT: "insertedContent": {
+// CHECK-NEXT: "text": "IDT_TEST_ABI "
+// CHECK-NEXT: }
+// CHECK-NEXT: }
+// CHECK-NEXT: ]
+// CHECK-NEXT: }
+// CHECK-NEXT: ]
+// CHECK-NEXT: }
+// CHECK-NEXT: ],
+// CHECK-NEXT: "properties": {
+// CHECK-NEXT: "usr": "c:@S@exported_record",
+public:
+  void method();
+};
+
+// A header found through a relative include path is located against the
+// directory idt was run from.
+// CHECK-RELATIVE: "text": "unexported public interface 'relative_function'"
+// CHECK-RELATIVE: "artifactLocation": {
+// CHECK-RELATIVE-NEXT: "uri": "{{(\./)?}}Sarif.h",
+// CHECK-RELATIVE-NEXT: "uriBaseId": "%SRCROOT%"
@@ -0,0 +1,38 @@
+// RUN: %idt -export-macro IDT_TEST_ABI -snapshot %t.old %s -- --target=x86_64-unknown-windows-msvc
+// RUN: %FileCheck %s -check-prefix CHECK-SNAPSHOT < %t.old
+// RUN: %idt -export-macro IDT_TEST_ABI -snapshot %t.new %s -- --target=x86_64-unknown-windows-msvc -DREVISION=2
+// RUN: not %idt-diff %t.old %t.new | %FileCheck %s -check-prefix CHECK-DIFF
+// RUN: %idt-diff %t.old %t.old | %FileCheck %s -check-prefix CHECK-IDENTICAL
+
+#define IDT_TEST_ABI __declspec(dllexport)
+
+IDT_TEST_ABI void stable_function(int);
+
+#if REVISION == 2
+IDT_TEST_ABI long changed_function();
+IDT_TEST_ABI void added_function();
+#else
+IDT_TEST_ABI int changed_function();
+IDT_TEST_ABI void removed_function();
+#endif
+
+class IDT_TEST_ABI stable_class {
+public:
+  virtual ~stable_class();
+  static int count;
+};
+
+// CHECK-SNAPSHOT: # idt snapshot 1
+// CHECK-SNAPSHOT: c:@F@changed_function#{{.}}function{{.}}changed_function{{.}}int (){{.}}dllexport
+// CHECK-SNAPSHOT: c:@F@removed_function#{{.}}function{{.}}removed_function{{.}}void (){{.}}dllexport
+// CHECK-SNAPSHOT: c:@F@stable_function#I#{{.}}function{{.}}stable_function{{.}}void (int){{.}}dllexport
+// CHECK-SNAPSHOT: c:@S@stable_class{{.}}class{{.}}stable_class{{.}}class{{.}}dllexport,polymorphic
+// CHECK-SNAPSHOT: c:@S@stable_class@count{{.}}variable{{.}}stable_class::count{{.}}int{{.}}dllexport,static
+
+// CHECK-DIFF: + function 'added_function': void () [dllexport]
+// CHECK-DIFF: ~ function 'changed_function': int () [dllexport] -> long () [dllexport]
+// CHECK-DIFF: - function 'removed_function': void () [dllexport]
+// CHECK-DIFF-NOT: stable
+// CHECK-DIFF: 1 added, 1 removed, 1 changed
+
+// CHECK-IDENTICAL: 0 added, 0 removed, 0 changed
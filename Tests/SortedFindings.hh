@@ -0,0 +1,41 @@
+// RUN: %idt -export-macro IDT_TEST_ABI -sort-findings -format jsonl %s %S/Inputs/SortedFindings.cc -- --target=x86_64-unknown-windows-msvc > %t.serial
+// RUN: %idt -export-macro IDT_TEST_ABI -sort-findings -format jsonl -j 2 -sort-memory 0 %s %S/Inputs/SortedFindings.cc -- --target=x86_64-unknown-windows-msvc > %t.parallel
+// RUN: diff %t.serial %t.parallel
+// RUN: %FileCheck %s < %t.serial
+// RUN: %idt -export-macro IDT_TEST_ABI -sort-findings -j 2 %s %S/Inputs/SortedFindings.cc -- --target=x86_64-unknown-windows-msvc 2>&1 | %FileCheck %s -check-prefix CHECK-TEXT
+
+#pragma once
+
+// CHECK: {"kind":"unexported-public-interface","file":"{{.*}}SortedFindings.cc",{{.*}}"name":"source_function",
+
+void second_function();
+// CHECK-NEXT: {"kind":"unexported-public-interface","file":"{{.*}}SortedFindings.hh","line":[[@LINE-1]],{{.*}}"name":"second_function",{{.*}}"unit":"{{.*}}SortedFindings.cc"}
+
+void first_function();
+// CHECK-NEXT: {"kind":"unexported-public-interface","file":"{{.*}}SortedFindings.hh","line":[[@LINE-1]],{{.*}}"name":"first_function",{{.*}}"unit":"{{.*}}SortedFindings.cc"}
+
+// The declarations of a macro expansion share its location, but are distinct
+// findings.
+#define DECLARE_FUNCTIONS(first, second) void first(); void second();
+DECLARE_FUNCTIONS(macro_first_function, macro_second_function)
+// CHECK-NEXT: {"kind":"unexported-public-interface","file":"{{.*}}SortedFindings.hh","line":[[@LINE-1]],{{.*}}"name":"macro_first_function",{{.*}}"unit":"{{.*}}SortedFindings.cc"}
+// CHECK-NEXT: {"kind":"unexported-public-interface","file":"{{.*}}SortedFindings.hh","line":[[@LINE-2]],{{.*}}"name":"macro_second_function",{{.*}}"unit":"{{.*}}SortedFindings.cc"}
+// CHECK-NOT: unexported-public-interface
+
+// The other diagnostics are written in the order of their translation units,
+// ahead of the findings.
+#if __INCLUDE_LEVEL__ == 0
+#warning "header translation unit"
+#endif
+
+// CHECK-TEXT: SortedFindings.cc:5:2: warning: "source translation unit"
+// CHECK-TEXT: SortedFindings.hh:28:2: warning: "header translation unit"
+// CHECK-TEXT-NOT: warning:
+// CHECK-TEXT: SortedFindings.cc:3:1: remark: unexported public interface 'source_function'
+// CHECK-TEXT: In file included from {{.*}}SortedFindings.cc:1:
+// CHECK-TEXT-NEXT: {{.*}}SortedFindings.hh:11:1: remark: unexported public interface 'second_function'
+// CHECK-TEXT: In file included from {{.*}}SortedFindings.cc:1:
+// CHECK-TEXT-NEXT: {{.*}}SortedFindings.hh:14:1: remark: unexported public interface 'first_function'
+// CHECK-TEXT: {{.*}}SortedFindings.hh:20:1: remark: unexported public interface 'macro_first_function'
+// CHECK-TEXT: {{.*}}SortedFindings.hh:20:1: remark: unexported public interface 'macro_second_function'
+// CHECK-TEXT-NOT: remark:
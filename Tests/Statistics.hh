@@ -0,0 +1,55 @@
+// RUN: %idt -export-macro IDT_TEST_ABI -statistics %s -- --target=x86_64-unknown-windows-msvc 2>&1 | %FileCheck %s
+// RUN: %idt -export-macro IDT_TEST_ABI %s -- --target=x86_64-unknown-windows-msvc 2>&1 | %FileCheck %s -check-prefix CHECK-DISABLED
+// RUN: %idt -export-macro IDT_TEST_ABI -export-report -stats-file %t.json %s -- --target=x86_64-unknown-windows-msvc
+// RUN: %FileCheck %s -check-prefix CHECK-JSON < %t.json
+
+#define IDT_TEST_ABI __declspec(dllexport)
+
+IDT_TEST_ABI void exported_function();
+void unexported_function();
+extern int unexported_variable;
+
+// CHECK: idt statistics: 1 translation units, 1 files read, {{[0-9]+}} declarations, 2 findings
+// CHECK-NEXT: phase wall cpu
+// CHECK-NEXT: setup {{[0-9.]+}}s {{[0-9.]+}}s
+// CHECK-NEXT: parse {{[0-9.]+}}s {{[0-9.]+}}s
+// CHECK-NEXT: traverse {{[0-9.]+}}s {{[0-9.]+}}s
+// CHECK-NEXT: fix-its {{[0-9.]+}}s {{[0-9.]+}}s
+// CHECK-NEXT: total {{[0-9.]+}}s {{[0-9.]+}}s
+// CHECK-NEXT: peak memory: {{[0-9.]+}} MiB
+// A scan without a report of the export surface collects no declarations.
+// CHECK-NEXT: inventory: 0 lookups, 0 hits
+// CHECK-NEXT: function declarations:
+// CHECK-NEXT: client 0
+// CHECK-NEXT: system header 0
+// CHECK-NEXT: dependent 0
+// CHECK-NEXT: has body 0
+// CHECK-NEXT: friend 0
+// CHECK-NEXT: deleted/defaulted 0
+// CHECK-NEXT: private 0
+// CHECK-NEXT: pure 0
+// CHECK-NEXT: annotated 1
+// CHECK-NEXT: ignored 0
+// CHECK-NEXT: class export 0
+// CHECK-NEXT: reported 1
+// CHECK-NEXT: slowest translation units:
+// CHECK-NEXT: {{[0-9.]+}}s {{.*}}Statistics.hh (setup {{[0-9.]+}}s, parse {{[0-9.]+}}s, traverse {{[0-9.]+}}s, fix-its {{[0-9.]+}}s; {{[0-9]+}} declarations, 2 findings)
+// CHECK-NEXT: largest translation units:
+// CHECK-NEXT: {{[0-9.]+}} MiB {{.*}}Statistics.hh (AST; peak memory {{[0-9.]+}} MiB)
+
+// CHECK-DISABLED-NOT: idt statistics
+
+// CHECK-JSON: "translation_units": 1,
+// CHECK-JSON-NEXT: "files": 1,
+// CHECK-JSON-NEXT: "declarations": {{[0-9]+}},
+// CHECK-JSON-NEXT: "findings": 2,
+// CHECK-JSON-NEXT: "peak_memory": {{[0-9]+}},
+// CHECK-JSON-NEXT: "inventory": {
+// CHECK-JSON-NEXT: "lookups": 3,
+// CHECK-JSON-NEXT: "hits": 0
+// CHECK-JSON-NEXT: },
+// CHECK-JSON-NEXT: "functions": {
+// CHECK-JSON: "annotated": 1,
+// CHECK-JSON: "reported": 1
+// CHECK-JSON: "units": [
+// CHECK-JSON: "path": "{{.*}}Statistics.hh",
@@ -0,0 +1,21 @@
+// RUN: %idt -export-macro IDT_TEST_ABI -format summary %s -- --target=x86_64-unknown-windows-msvc 2>&1 | %FileCheck %s
+// RUN: %idt -export-macro IDT_TEST_ABI -format summary -sort-findings -j 2 %s %s -- --target=x86_64-unknown-windows-msvc 2>&1 | %FileCheck %s
+
+#define IDT_TEST_ABI __declspec(dllexport)
+
+void unexported_function();
+extern int unexported_variable;
+IDT_TEST_ABI inline void exported_inline_function() {}
+
+class record {
+  IDT_TEST_ABI void exported_private_method();
+};
+
+// CHECK-NOT: remark:
+// CHECK: unexported-public-interface 2
+// CHECK-NEXT: exported-private-interface 1
+// CHECK-NEXT: exported-inline-interface 1
+// CHECK-NEXT: unexported-polymorphic-class 0
+// CHECK-NEXT: polymorphic-class-without-key-function 0
+// CHECK-NEXT: member-level-interface 0
+// CHECK-NOT: remark:
@@ -0,0 +1,21 @@
+// RUN: %idt -export-macro IDT_TEST_ABI -j 2 -time-trace %t.json -time-trace-granularity 0 -export-report %s %S/Inputs/TimeTrace.cc -- --target=x86_64-unknown-windows-msvc 2>&1 | %FileCheck %s
+// RUN: %FileCheck %s -check-prefix CHECK-TRACE < %t.json
+
+#pragma once
+
+#define IDT_TEST_ABI __declspec(dllexport)
+
+IDT_TEST_ABI void exported_function();
+void unexported_function();
+
+// CHECK-DAG: TimeTrace.hh:9:1: remark: unexported public interface 'unexported_function'
+// CHECK-DAG: library 'IDT_TEST_ABI': 1 exported symbols
+// CHECK-DAG: functions: 1 exported, 1 unexported public, 0 exported private
+
+// CHECK-TRACE: "traceEvents"
+// CHECK-TRACE-DAG: "name":"idt worker 0"
+// CHECK-TRACE-DAG: "name":"idt worker 1"
+// CHECK-TRACE-DAG: "name":"Translation unit"
+// CHECK-TRACE-DAG: "name":"Frontend"
+// CHECK-TRACE-DAG: "name":"Traverse"
+// CHECK-TRACE-DAG: "name":"Inventory lookup"